@@ -0,0 +1,87 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "vector.h"
+
+enum Page_mode { standard_pages, transparent_huge_pages, hugetlbfs_pages }; // Pages de la mémoire des étoiles et de l'arbre
+
+/**
+ * \brief Choisit les pages des allocations suivantes (à appeler avant de créer les étoiles).
+ *
+ * standard_pages : new et delete, comme les autres conteneurs. transparent_huge_pages : projections alignées sur 2 Mo
+ * et madvise(MADV_HUGEPAGE), le noyau les sert en grandes pages s'il en a. hugetlbfs_pages : MAP_HUGETLB, grandes pages
+ * réservées par l'administrateur (vm.nr_hugepages), sinon repli sur transparent_huge_pages. Hors Linux : standard_pages.
+ * \param mode
+ */
+void set_page_mode(Page_mode mode);
+
+/**
+ * \brief Alloue de la mémoire selon le mode de pages : projection directe au-delà de 1 Mo, sinon bloc d'une classe de
+ * taille (de 64 en 64 octets jusqu'à 4 Ko, puis puissances de deux) pris dans des plages de grandes pages partagées, avec une liste libre par thread (son excédent retourne au pool partagé).
+ * \param bytes
+ * \return aligné sur 64 octets
+ */
+void *arena_allocate(std::size_t bytes);
+
+/**
+ * \brief Libère une allocation de arena_allocate.
+ * \param pointer
+ * \param bytes taille demandée à l'allocation
+ */
+void arena_deallocate(void *pointer, std::size_t bytes);
+
+/**
+ * \brief Plages de 2 Mo découpées jusqu'ici pour les petites allocations (jamais rendues au système) : stable d'un pas
+ * à l'autre une fois l'arbre construit, quel que soit le thread qui libère.
+ * \return
+ */
+std::size_t arena_slabs();
+
+/**
+ * \brief Taille des pages des allocations suivantes, à respecter pour rendre une partie de leur mémoire au système.
+ * \return 2 Mo hors standard_pages, sinon la taille des pages du système
+ */
+std::size_t arena_page_size();
+
+/**
+ * \brief Mémoire du processus effectivement servie en grandes pages (AnonHugePages et Hugetlb de /proc/self/smaps_rollup).
+ * \return en octets, 0 si illisible
+ */
+std::size_t huge_page_bytes();
+
+/**
+ * \class Arena_allocator
+ * \brief Allocateur des conteneurs d'étoiles et des enfants des blocs : passe par arena_allocate.
+ */
+template<typename T>
+class Arena_allocator {
+
+public:
+
+	using value_type = T;
+
+	Arena_allocator() = default;
+
+	template<typename U>
+	Arena_allocator(const Arena_allocator<U> &) {}
+
+	T *allocate(std::size_t count) {
+		return static_cast<T *>(arena_allocate(count * sizeof(T)));
+	}
+
+	void deallocate(T *pointer, std::size_t count) {
+		arena_deallocate(pointer, count * sizeof(T));
+	}
+
+	template<typename U>
+	bool operator==(const Arena_allocator<U> &) const {
+		return true;
+	}
+
+	template<typename U>
+	bool operator!=(const Arena_allocator<U> &) const {
+		return false;
+	}
+};
+
+#endif
@@ -3,9 +3,33 @@
 
 #include "vector.h"
 #include "star.h"
+#include "compute.h"
 
 
 
+/**
+ * \struct Bounding_box
+ * \brief Boîte englobante alignée sur les axes.
+ */
+struct Bounding_box {
+	glm::dvec3 min{ std::numeric_limits<double>::max() };
+	glm::dvec3 max{ std::numeric_limits<double>::lowest() };
+
+	/**
+	 * \brief Agrandit la boîte pour contenir un point.
+	 * \param point
+	 */
+	void extend(const glm::dvec3 &point);
+
+	/**
+	 * \brief Agrandit la boîte pour contenir une autre boîte (réduction entre threads).
+	 * \param box
+	 */
+	void merge(const Bounding_box &box);
+
+	[[nodiscard]] bool is_empty() const;
+};
+
 // Classe définissant une zone de l'algorithme de Barnes–Hut. EDIT : commentaire de doc :
 /**
  * \class Block
@@ -15,21 +39,31 @@ class Block {
 
 public:
 
-	bool as_stars{ false };        // Présence d'étoiles dans le bloc
-	bool as_children{ false };    // Présence de blocs enfants
-	bool as_parents{ false };        // Présence de blocs parents
-	std::size_t parent{ 0 };            // Indice du bloc parent. EDIT : 0 par défaut, ou une autre valeur ? Genre le max de int.
+	using container = std::vector<Block, Arena_allocator<Block>>;    // Enfants, dans les mêmes pages que les étoiles
+
+#ifdef GALAXY_COMPACT
+	using moment_type = float;    // Mode compact : le quadripôle n'est qu'une correction, la simple précision lui suffit (en masses solaires années-lumière carrées)
+#else
+	using moment_type = double;
+#endif
+
 	glm::dvec3 position{ 0, 0, 0 };        // Position du bloc
 	double mass{ 0 };            // Masse contenue dans le bloc (en kilogrames)
 	glm::dvec3 mass_center{ 0, 0, 0 };    // Centre de gravité du bloc
-	size_t nb_stars{ 0 };        // Nombre d'étoiles contenues dans le block
-	double size{ 0 }, halfsize{ 0 };    // Taille du bloc (en mètres)
+	std::array<moment_type, 6> quadrupole{};    // Moment quadripolaire sans trace autour du centre de gravité (xx, xy, xz, yy, yz, zz)
+	Star::index_type nb_stars{ 0 };        // Nombre d'étoiles contenues dans le block
+	bool as_children{ false };    // Présence de blocs enfants
+	double size{ 0 };    // Taille du bloc (en mètres), agrandie par refit pour contenir les étoiles qui en sont sorties
 
-	std::variant<Star::container::iterator, std::vector<Block>> contains;
+	std::variant<Star::container::iterator, container> contains;
 
 	Block() = default;
 
+#ifdef GALAXY_COMPACT
+	~Block() = default; // Pas de table virtuelle
+#else
 	virtual ~Block() = default;
+#endif
 
 	Block(const Block &block) = default;
 
@@ -37,25 +71,59 @@ public:
 
 	void update_mass_center_and_mass(const Star::range &stars);
 
-	void divide(Star::range galaxy);
+	/**
+	 * \brief Construit le sous-arbre des étoiles du bloc.
+	 * \param galaxy
+	 * \param compute partitions des grands blocs (ceux du haut de l'arbre) en parallèle
+	 */
+	void divide(Star::range galaxy, const Compute &compute = Compute());
+
+	/**
+	 * \brief Recalcule les centres de gravité sans réorganiser l'arbre (les étoiles ont bougé depuis divide). Les blocs
+	 * restent centrés sur leur position et grandissent pour contenir leurs étoiles : le critère d'ouverture et la coupure
+	 * du TreePM restent valables.
+	 */
+	void refit();
 
 	void set_size(const double &size);
+
+	/**
+	 * \brief Recalcule le moment quadripolaire à partir de ceux des enfants (théorème de transport).
+	 */
+	void update_quadrupole();
 };
 
 /**
- * \brief Permet de savoir si l'étoile est dans un bloc.
+ * \brief Accélération due au moment quadripolaire d'un bloc (à ajouter à celle du monopôle).
  * \param block
- * \param star
+ * \param star_to_mass position de l'étoile moins le centre de gravité du bloc
+ * \param distance norme de star_to_mass
+ * \return
+ */
+glm::dvec3 quadrupole_acceleration(const Block &block, const glm::dvec3 &star_to_mass, const double &distance);
+
+/**
+ * \brief Calcule la boîte englobante d'un ensemble d'étoiles.
+ * \param stars
+ * \param compute
  * \return
  */
-bool is_in(const Block &block, const Star &star);
+Bounding_box bounding_box(const Star::range &stars, const Compute &compute = Compute());
+
+/**
+ * \brief Mémoire allouée pour un arbre (le bloc et tous ses descendants, y compris les enfants vides).
+ * \param block
+ * \return en octets
+ */
+std::size_t tree_memory(const Block &block);
 
 /**
- * \brief Génère les blocs.
- * \param area
+ * \brief Génère les blocs, la racine est le plus petit cube contenant la boîte englobante des étoiles.
+ * \param box
  * \param block
  * \param galaxy
+ * \param compute
  */
-void create_blocks(const double &area, Block &block, Star::range &galaxy);
+void create_blocks(const Bounding_box &box, Block &block, Star::range &galaxy, const Compute &compute = Compute());
 
 #endif
\ No newline at end of file
@@ -0,0 +1,166 @@
+#ifndef COMPUTE_H
+#define COMPUTE_H
+
+#include "star.h"
+
+enum Backend { std_threads, parallel_stl, openmp }; // Exécution des boucles parallèles (threads du projet, algorithmes parallèles de la STL ou OpenMP)
+
+/**
+ * \class Thread_pool
+ * \brief Threads du backend std_threads, créés une fois : chaque lot de tâches les réveille au lieu de lancer des
+ * threads. Un seul lot à la fois : celui d'un autre thread (rendu) attend la fin du lot en cours, celui d'une tâche
+ * du lot (imbriqué) est refusé.
+ */
+class Thread_pool {
+
+public:
+
+	/**
+	 * \brief Lance les threads.
+	 * \param n_worker threads en plus de celui qui soumet les lots (il travaille aussi)
+	 */
+	explicit Thread_pool(std::size_t n_worker);
+
+	virtual ~Thread_pool();
+
+	Thread_pool(const Thread_pool &pool) = delete; // Possède des threads
+
+	Thread_pool &operator=(const Thread_pool &pool) = delete;
+
+	/**
+	 * \brief Exécute un lot de tâches avec les threads du pool et le thread appelant, et attend sa fin.
+	 * \param count nombre de tâches
+	 * \param task appelée une fois par indice de tâche
+	 * \return false depuis une tâche d'un lot de ce pool : rien n'a été exécuté
+	 */
+	bool run(std::size_t count, const std::function<void(std::size_t)> &task);
+
+private:
+
+	// Lot en cours, sur la pile de run : les tâches sont prises dans l'ordre par les threads libres
+	struct Job {
+		const std::function<void(std::size_t)> *task;
+		std::size_t count;
+		std::atomic<std::size_t> next{ 0 };
+
+		void work();
+	};
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake, finished;
+	Job *job{ nullptr };
+	std::uint64_t generation{ 0 };    // Numéro du dernier lot soumis
+	std::size_t active{ 0 };          // Threads du pool travaillant sur le lot
+	bool stop{ false };
+	std::mutex submit;    // Tenu par le thread qui soumet, pendant tout le lot
+
+	void worker_loop();
+};
+
+/**
+ * \class Compute
+ * \brief Exécute les boucles parallèles de la simulation (intégration, réductions, partitions, couleurs) sur le
+ * backend choisi.
+ *
+ * std_threads : n_thread threads du projet, créés une fois (Thread_pool partagé par les copies), un intervalle contigu
+ * chacun. parallel_stl : std::execution::par de la bibliothèque standard (TBB avec GCC, disponible quand la compilation
+ * définit GALAXY_PARALLEL_STL), sur des intervalles plus petits que ses threads se répartissent. openmp : boucles schedule(runtime), réglées par OMP_SCHEDULE
+ * (dynamic par défaut) et OMP_NUM_THREADS (n_thread par défaut), disponible quand la compilation définit GALAXY_OPENMP.
+ * Les deux derniers sont des backends à tâches : ils acceptent les tâches imbriquées (construction de l'arbre).
+ *
+ * Les réductions combinent les résultats des intervalles dans leur ordre : même résultat d'une exécution à l'autre pour
+ * un backend et un nombre de threads donnés.
+ */
+class Compute {
+
+public:
+
+	Backend backend{ std_threads };
+	std::size_t n_thread{ 1 };
+	std::size_t grain{ 4096 };    // Éléments minimum par intervalle : en dessous, le lancement coûte plus qu'il ne rapporte
+	std::shared_ptr<Thread_pool> pool;    // std_threads avec plusieurs threads : partagé par les copies
+
+	Compute() = default;
+
+	/**
+	 * \brief Choisit le backend (std_threads s'il n'a pas été compilé).
+	 * \param backend
+	 * \param n_thread remplacé par OMP_NUM_THREADS s'il est défini (openmp)
+	 */
+	Compute(Backend backend, std::size_t n_thread);
+
+	virtual ~Compute() = default;
+
+	Compute(const Compute &compute) = default;
+
+	Compute &operator=(const Compute &compute) = default;
+
+	/**
+	 * \brief Indique si un backend a été compilé.
+	 * \param backend
+	 * \return
+	 */
+	[[nodiscard]] static bool is_available(Backend backend);
+
+	/**
+	 * \brief Nombre d'intervalles utilisés par for_ranges et reduce.
+	 * \param count nombre d'éléments
+	 * \return entre 1 et count (1 si count est nul)
+	 */
+	[[nodiscard]] std::size_t chunks(std::size_t count) const;
+
+	/**
+	 * \brief Indique si un travail est découpé en tâches imbriquées (backends à tâches, au moins grain éléments).
+	 * \param count nombre d'éléments du travail
+	 * \return
+	 */
+	[[nodiscard]] bool is_nested(std::size_t count) const;
+
+	/**
+	 * \brief Lance des tâches indépendantes en parallèle et attend leur fin (depuis une tâche : tâches imbriquées, sauf
+	 * avec std_threads, qui les exécute alors à la suite).
+	 * \param count nombre de tâches
+	 * \param task appelée une fois par indice de tâche
+	 */
+	void tasks(std::size_t count, const std::function<void(std::size_t)> &task) const;
+
+	/**
+	 * \brief Découpe [0, count) en intervalles contigus traités en parallèle.
+	 * \param count
+	 * \param work appelée avec l'indice de l'intervalle (inférieur à chunks(count)), son début et sa fin
+	 */
+	void for_ranges(std::size_t count, const std::function<void(std::size_t, std::size_t, std::size_t)> &work) const;
+
+	/**
+	 * \brief Réduction parallèle : map sur chaque intervalle, puis combine dans l'ordre des intervalles.
+	 * \param count
+	 * \param init élément neutre de combine
+	 * \param map résultat partiel d'un intervalle [début, fin)
+	 * \param combine
+	 * \return
+	 */
+	template<typename T, typename Map, typename Combine>
+	T reduce(std::size_t count, T init, const Map &map, const Combine &combine) const {
+		std::vector<T> partial(chunks(count), init);
+
+		for_ranges(count, [&partial, &map](std::size_t chunk, std::size_t begin, std::size_t end) {
+			partial[chunk] = map(begin, end);
+		});
+
+		for (const auto &value : partial)
+			init = combine(init, value);
+
+		return init;
+	}
+
+	/**
+	 * \brief Partition parallèle (non stable, comme std::partition) : les étoiles vérifiant predicate en premier.
+	 * \param stars
+	 * \param predicate
+	 * \return première étoile ne vérifiant pas predicate
+	 */
+	Star::container::iterator partition(const Star::range &stars, const std::function<bool(const Star &)> &predicate) const;
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef DENSITY_H
+#define DENSITY_H
+
+#include "block.h"
+
+/**
+ * \class Density_estimator
+ * \brief Densité de masse par les k plus proches voisins (noyau SPH), indépendante du calcul de la gravité.
+ *
+ * Pour chaque étoile, les neighbours plus proches voisins (elle comprise) sont cherchés dans l'octree ; la distance au
+ * plus lointain donne le rayon h du noyau spline cubique, et la densité vaut sum_j m_j W(r_j, h). Le coût ne dépend que
+ * de la fréquence d'appel, choisie indépendamment du pas de la gravité.
+ */
+class Density_estimator {
+
+public:
+
+	//! Nombre de voisins (l'étoile elle-même comprise)
+	std::size_t neighbours{ 32 };
+	//! Densité de chaque étoile, indexée par Star::index (en masses solaires par année-lumière cube)
+	std::vector<double> densities;
+
+	Density_estimator() = default;
+
+	virtual ~Density_estimator() = default;
+
+	Density_estimator(const Density_estimator &estimator) = default;
+
+	Density_estimator &operator=(const Density_estimator &estimator) = default;
+
+	/**
+	 * \brief Estime la densité de toutes les étoiles.
+	 * \param root arbre construit sur les positions actuelles des étoiles
+	 * \param stars
+	 * \param nb_ids nombre d'identifiants (taille de densities)
+	 * \param compute
+	 */
+	void estimate(const Block &root, const Star::range &stars, std::size_t nb_ids, const Compute &compute);
+};
+
+/**
+ * \brief Noyau spline cubique normalisé, de support h (nul au-delà).
+ * \param distance
+ * \param h
+ * \return
+ */
+double sph_kernel(const double &distance, const double &h);
+
+#endif
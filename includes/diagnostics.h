@@ -0,0 +1,88 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include "block.h"
+#include "direct.h"
+#include "potential.h"
+
+/**
+ * \class Diagnostics
+ * \brief Mesures de précision de la simulation : énergie, quantité de mouvement, moment cinétique, rapport du viriel
+ * et erreur de la force sur un échantillon d'étoiles comparée à la somme directe.
+ *
+ * Prévu pour être appelé tous les quelques pas, juste après le calcul des forces du premier sous-pas : positions et
+ * arbre sont alors à jour. Avec le saute-mouton les vitesses ont une demi-poussée de retard, l'énergie oscille donc
+ * légèrement autour de sa valeur ; c'est sa dérive d'une mesure à l'autre qui compte.
+ */
+class Diagnostics {
+
+public:
+
+	//! Nombre d'étoiles comparées à la somme directe (coût : samples * N interactions, 0 : erreur de la force non mesurée)
+	std::size_t samples{ 256 };
+	//! Potentiels analytiques ajoutés à l'énergie potentielle (nullptr : aucun)
+	const External_field *external{ nullptr };
+
+	double kinetic_energy{ 0. };
+	double potential_energy{ 0. };          // Calculée avec l'arbre (monopôles, même angle d'ouverture que la force) et le champ extérieur
+	double virial_ratio{ 0. };              // 2 K / |W| (1 à l'équilibre)
+	glm::dvec3 momentum{ 0, 0, 0 };
+	glm::dvec3 angular_momentum{ 0, 0, 0 };  // Par rapport à l'origine
+	std::array<double, 3> force_errors{};   // Erreur relative de l'accélération : médiane, 90e et 99e centiles
+
+	Diagnostics() = default;
+
+	virtual ~Diagnostics() = default;
+
+	Diagnostics(const Diagnostics &diagnostics) = default;
+
+	Diagnostics &operator=(const Diagnostics &diagnostics) = default;
+
+	/**
+	 * \brief Effectue toutes les mesures.
+	 * \param stars étoiles vivantes
+	 * \param block racine de l'arbre construit sur ces étoiles
+	 * \param precision angle d'ouverture utilisé pour l'énergie potentielle
+	 * \param acceleration accélération donnée par le solveur courant pour une copie d'étoile
+	 * \param compute
+	 */
+	void measure(const Star::range &stars, const Block &block, const double &precision,
+				 const std::function<glm::dvec3(Star)> &acceleration, const Compute &compute);
+
+	/**
+	 * \brief Écrit une ligne de résultats, avec les dérives relatives depuis la première mesure.
+	 * \param stream
+	 * \param step numéro du pas
+	 */
+	void print(std::ostream &stream, std::size_t step);
+
+private:
+
+	bool has_reference{ false };
+	double initial_energy{ 0. };
+	glm::dvec3 initial_momentum{ 0, 0, 0 };
+	glm::dvec3 initial_angular_momentum{ 0, 0, 0 };
+	double total_mass{ 0. };
+	double typical_speed{ 0. };             // Vitesse quadratique moyenne : échelle de la dérive de la quantité de mouvement
+	Direct direct;
+};
+
+/**
+ * \brief Potentiel gravitationnel en un point par le parcours de l'arbre (monopôles).
+ * \param precision
+ * \param position
+ * \param block
+ * \return
+ */
+double potential_calculation(const double &precision, const glm::dvec3 &position, const Block &block);
+
+/**
+ * \brief Écrit la mémoire occupée par étoile : étoiles (capacité du conteneur), arbre et table des identifiants.
+ * \param stream
+ * \param galaxy
+ * \param root arbre construit sur les étoiles vivantes
+ * \param slots
+ */
+void print_memory(std::ostream &stream, const Star::container &galaxy, const Block &root, const std::vector<Star::index_type> &slots);
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef DIRECT_H
+#define DIRECT_H
+
+#include "compute.h"
+
+/**
+ * \class Direct
+ * \brief Somme directe en O(N^2) : solveur exact pour les petites galaxies et référence pour l'erreur des arbres.
+ *
+ * Les sources sont copiées en structure de tableaux (x, y, z, masse). Les cibles sont traitées par tuiles de
+ * tile_size étoiles dont les accumulateurs restent en cache : la boucle interne parcourt la tuile pour une source
+ * donnée, sans réduction, et se vectorise sans options de calcul approché. Même noyau et même densité que
+ * force_and_density_calculation entre deux étoiles.
+ */
+class Direct {
+
+public:
+
+	static constexpr std::size_t tile_size = 64;
+
+	Direct() = default;
+
+	virtual ~Direct() = default;
+
+	Direct(const Direct &direct) = default;
+
+	Direct &operator=(const Direct &direct) = default;
+
+	/**
+	 * \brief Copie les positions et les masses des sources.
+	 * \param sources
+	 */
+	void load(const Star::range &sources);
+
+	/**
+	 * \brief Calcule l'accélération et la densité des cibles dues à toutes les sources chargées.
+	 * \param targets étoiles mises à jour (en général les mêmes que les sources : l'interaction avec soi-même est ignorée)
+	 * \param compute
+	 */
+	void solve(const Star::range &targets, const Compute &compute) const;
+
+	/**
+	 * \brief Accélération exacte en un point (référence pour mesurer l'erreur d'un autre solveur).
+	 * \param position
+	 * \param density densité au point
+	 * \return
+	 */
+	[[nodiscard]] glm::dvec3 acceleration(const glm::dvec3 &position, double &density) const;
+
+private:
+
+	std::vector<double> x, y, z, mass;
+
+	void solve_tile(const Star::range &tile) const;
+};
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef DOMAIN_H
+#define DOMAIN_H
+
+#include "block.h"
+#include "transport.h"
+
+/**
+ * \class Domain
+ * \brief Décomposition de la simulation entre plusieurs rangs le long d'une courbe de Morton (Barnes-Hut seulement).
+ *
+ * Chaque rang possède les étoiles dont la clé de Morton tombe dans son intervalle, construit son arbre sur elles et
+ * reçoit des autres rangs leur arbre localement essentiel : les étoiles et les blocs (en pseudo-étoiles, monopôles
+ * seulement) que le critère d'ouverture demande pour n'importe quel point de sa boîte. Ces fantômes forment un second
+ * arbre parcouru en plus du sien. Les séparateurs sont recalculés à chaque pas à partir d'un échantillon des clés de
+ * chaque rang, puis les étoiles sorties de leur intervalle migrent.
+ */
+class Domain {
+
+public:
+
+	Transport *transport;
+	Compute compute;                            // Réductions et arbre des fantômes
+	std::size_t samples{ 64 };                  // Clés échantillonnées par rang pour placer les séparateurs
+	Bounding_box box;                           // Boîte de toutes les étoiles (tous les rangs)
+	glm::dvec3 mass_center{ 0, 0, 0 };          // Centre de gravité de toutes les étoiles
+	std::vector<std::uint64_t> splits;          // Le rang r possède les clés de [splits[r - 1], splits[r])
+	std::vector<Bounding_box> domains;          // Boîte des étoiles de chaque rang, pour l'arbre localement essentiel
+	Star::container ghosts;                     // Étoiles et pseudo-étoiles reçues des autres rangs
+	Block ghost_root;                           // Arbre des fantômes (nb_stars : étoiles représentées, pseudo-étoiles comprises)
+
+	explicit Domain(Transport &transport);
+
+	virtual ~Domain() = default;
+
+	Domain(const Domain &domain) = delete;      // ghost_root pointe dans ghosts
+
+	Domain &operator=(const Domain &domain) = delete;
+
+	[[nodiscard]] bool is_distributed() const;
+
+	/**
+	 * \brief Première répartition : tous les rangs ont créé toutes les étoiles, chacun en garde une tranche puis migre.
+	 * \param galaxy
+	 * \param alive_galaxy
+	 * \param slots
+	 */
+	void distribute(Star::container &galaxy, Star::range &alive_galaxy, std::vector<Star::index_type> &slots);
+
+	/**
+	 * \brief Recalcule la boîte, le centre de gravité global et les séparateurs.
+	 * \param stars étoiles locales
+	 */
+	void balance(const Star::range &stars);
+
+	/**
+	 * \brief Envoie les étoiles à leur rang (les étoiles mortes sont supprimées du conteneur au passage).
+	 * \param galaxy
+	 * \param alive_galaxy toutes les étoiles du conteneur après l'appel
+	 * \param slots mis à jour pour les étoiles locales
+	 */
+	void migrate(Star::container &galaxy, Star::range &alive_galaxy, std::vector<Star::index_type> &slots);
+
+	/**
+	 * \brief Échange les arbres localement essentiels et construit l'arbre des fantômes.
+	 * \param root arbre local
+	 * \param stars étoiles locales
+	 * \param precision angle d'ouverture du parcours
+	 */
+	void exchange_essential(const Block &root, const Star::range &stars, const double &precision);
+
+	/**
+	 * \brief Rassemble toutes les étoiles sur le rang 0 (affichage).
+	 * \param stars étoiles locales
+	 * \param densities densité par identifiant à transmettre à la place de Star::density (nullptr : celle de l'étoile)
+	 * \return toutes les étoiles sur le rang 0, rien ailleurs
+	 */
+	Star::container gather(const Star::range &stars, const std::vector<double> *densities);
+
+	/**
+	 * \brief Vrai si un rang au moins a flag vrai.
+	 * \param flag
+	 * \return
+	 */
+	bool any(bool flag);
+
+private:
+
+	std::size_t owner(const Star &star) const;
+};
+
+/**
+ * \brief Clé de Morton (21 bits par axe, entrelacés) d'une position dans le cube englobant une boîte.
+ * \param position
+ * \param box
+ * \return
+ */
+std::uint64_t morton_key(const glm::dvec3 &position, const Bounding_box &box);
+
+#endif
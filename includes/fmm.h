@@ -0,0 +1,109 @@
+#ifndef FMM_H
+#define FMM_H
+
+#include "block.h"
+
+enum Solver { barnes_hut, fast_multipole, tree_pm, direct_sum }; // Méthodes de calcul de la gravité
+
+/**
+ * \class Fmm
+ * \brief Méthode multipolaire rapide (FMM) en coordonnées cartésiennes, construite sur l'octree de Block.
+ *
+ * Les blocs non vides sont aplatis en cellules (ordre préfixe) portant un développement multipolaire et un
+ * développement local d'ordre `order` autour de leur centre de gravité. Un bloc d'au plus leaf_size étoiles devient une
+ * feuille : ses étoiles sont contiguës dans le conteneur et interagissent directement avec les feuilles voisines. Le
+ * parcours double de l'arbre remplace les interactions étoile-bloc de Barnes-Hut par des interactions bloc-bloc
+ * (translation multipôle -> local), le coût devient linéaire en nombre d'étoiles.
+ */
+class Fmm {
+
+public:
+
+	Fmm() = default;
+
+	explicit Fmm(int order, std::size_t leaf_size = 16);
+
+	virtual ~Fmm() = default;
+
+	Fmm(const Fmm &fmm) = default;
+
+	Fmm &operator=(const Fmm &fmm) = default;
+
+	/**
+	 * \brief Change l'ordre des développements (précalcule les tables de multi-indices).
+	 * \param order 1 (monopôle seul pour la force) ou plus
+	 */
+	void set_order(int order);
+
+	[[nodiscard]] int get_order() const;
+
+	//! Nombre maximal d'étoiles dans une feuille
+	std::size_t leaf_size{ 16 };
+
+	/**
+	 * \brief Calcule l'accélération et la densité de toutes les étoiles de l'arbre.
+	 * \param root racine construite par create_blocks
+	 * \param precision angle d'ouverture : deux cellules interagissent si (r_a + r_b) < precision * distance
+	 * \param compute passes montante et descendante, par sous-arbres (plusieurs par thread)
+	 */
+	void solve(const Block &root, const double &precision, const Compute &compute);
+
+private:
+
+	/**
+	 * \struct Cell
+	 * \brief Bloc non vide aplati.
+	 */
+	struct Cell {
+		glm::dvec3 center{ 0, 0, 0 };           // Centre des développements (centre de gravité du bloc)
+		double radius{ 0 };                     // Rayon de la sphère centrée sur center contenant toutes les étoiles
+		std::size_t nb_stars{ 0 };
+		std::size_t end{ 0 };                   // Indice suivant le dernier descendant (ordre préfixe)
+		bool is_leaf{ false };
+		Star::range stars;                      // Étoiles du bloc (contiguës : divide partitionne sur place)
+	};
+
+	/**
+	 * \struct Term
+	 * \brief Terme précalculé d'une translation : target += source * factor[power] (* sign).
+	 */
+	struct Term {
+		std::size_t target, source, power;
+		double sign;
+	};
+
+	int order{ 0 };
+	std::size_t nb_coefficients{ 0 };
+	std::vector<std::array<int, 3>> multi_indices;      // Triés par degré croissant
+	std::vector<int> lookup;                            // (i, j, k) -> indice dans multi_indices
+	std::vector<double> inverse_factorials;             // 1 / (i! j! k!)
+	std::vector<std::array<int, 6>> lower_indices;      // Indices de n - e_axe puis de n - 2 e_axe (-1 si invalide)
+	std::vector<Term> nested_terms;                     // Multipôle -> multipôle et local -> local
+	std::vector<Term> m2l_terms;                        // Multipôle -> local
+	std::array<std::vector<Term>, 3> gradient_terms;    // Local -> gradient en une étoile (une liste par axe)
+
+	std::vector<Cell> cells;
+	std::vector<double> multipoles;
+	std::vector<double> locals;
+	std::vector<double> densities;
+
+	[[nodiscard]] int index(int i, int j, int k) const;
+
+	std::size_t flatten(const Block &block);
+
+	void upward(std::size_t cell, std::vector<double> &powers);
+
+	void interact(std::size_t target, std::size_t source, const double &precision, std::vector<double> &buffer);
+
+	void particle_to_particle(std::size_t target, std::size_t source);
+
+	void multipole_to_local(std::size_t target, std::size_t source, const glm::dvec3 &r, std::vector<double> &buffer);
+
+	void downward(std::size_t cell, std::vector<double> &powers);
+
+	void derivatives(const glm::dvec3 &r, std::vector<double> &result) const;
+
+	void scaled_powers(const glm::dvec3 &d, std::vector<double> &result) const;
+};
+
+#endif
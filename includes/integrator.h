@@ -0,0 +1,91 @@
+#ifndef INTEGRATOR_H
+#define INTEGRATOR_H
+
+#include "star.h"
+
+enum Scheme { euler, leapfrog, forest_ruth }; // Schémas d'intégration possibles
+
+/**
+ * \class Integrator
+ * \brief Schéma d'intégration vu comme une composition d'étapes de saute-mouton (poussée, dérive, poussée).
+ *
+ * Une étape de poids w fait avancer le temps de w * step : poussée de opening * w * step, dérive de w * step, puis
+ * poussée de closing * w * step. La poussée de fin d'une étape est fusionnée avec celle du début de la suivante, qui
+ * utilise la même force : une seule évaluation de force par étape. Chaque étape est découpée en sous-pas de niveau
+ * fin (pas individuels en puissances de deux). Euler (semi-implicite) : une étape, poussée entière avant la dérive.
+ * Saute-mouton : une étape, deux demi-poussées. Forest-Ruth (Yoshida, ordre 4) : trois étapes de saute-mouton de
+ * poids w1, w0, w1 avec w0 < 0, soit trois forces par pas pour une erreur en step^4.
+ */
+class Integrator {
+
+public:
+
+	//! Poids des étapes (leur somme vaut 1)
+	std::vector<double> weights;
+	//! Part de la poussée appliquée avant la dérive
+	double opening{ 0.5 };
+	//! Part de la poussée appliquée après la dérive
+	double closing{ 0.5 };
+
+	Integrator() = default;
+
+	/**
+	 * \brief Construit un schéma.
+	 * \param scheme
+	 * \param step pas de temps de la boucle
+	 * \param max_rung niveau de pas individuel le plus fin
+	 * \param accuracy critère du pas individuel
+	 * \param length longueur caractéristique du critère du pas individuel
+	 */
+	Integrator(Scheme scheme, const double &step, int max_rung, const double &accuracy, const double &length);
+
+	virtual ~Integrator() = default;
+
+	Integrator(const Integrator &integrator) = default;
+
+	Integrator &operator=(const Integrator &integrator) = default;
+
+	[[nodiscard]] std::size_t stages() const;
+
+	[[nodiscard]] std::size_t substeps() const;
+
+	[[nodiscard]] int get_max_rung() const;
+
+	/**
+	 * \brief Passe à l'étape suivante (appelé quand aucun worker ne tourne).
+	 * \param stage
+	 */
+	void begin_stage(std::size_t stage);
+
+	/**
+	 * \brief Indique si l'étoile commence un pas à ce sous-pas (et a donc besoin d'une nouvelle force).
+	 * \param star
+	 * \param substep
+	 * \return
+	 */
+	[[nodiscard]] bool is_active(const Star &star, std::size_t substep) const;
+
+	/**
+	 * \brief Termine le pas précédent de l'étoile, choisit son nouveau niveau et commence le nouveau pas (étoile active).
+	 * \param star
+	 * \param substep
+	 */
+	void kick(Star &star, std::size_t substep) const;
+
+	/**
+	 * \brief Fait dériver l'étoile d'un sous-pas (toutes les étoiles, à chaque sous-pas).
+	 * \param star
+	 */
+	void drift(Star &star) const;
+
+private:
+
+	double step{ 0. };
+	int max_rung{ 0 };
+	double accuracy{ 0. };
+	double length{ 0. };
+	double duration{ 0. };              // Durée de l'étape courante
+	double previous_duration{ 0. };     // Durée de l'étape précédente (0 avant la première : rien à terminer)
+};
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#include "block.h"
+
+/**
+ * \struct Numa_node
+ * \brief Un noeud NUMA : une mémoire et les coeurs qui y accèdent directement.
+ */
+struct Numa_node {
+	int id{ 0 };
+	std::vector<int> cpus;
+};
+
+/**
+ * \brief Lit la topologie dans /sys/devices/system/node (Linux).
+ * \return noeuds ayant des coeurs, vide si la topologie est illisible
+ */
+std::vector<Numa_node> detect_numa_nodes();
+
+/**
+ * \class Numa_placement
+ * \brief Place threads et données sur les noeuds NUMA : chaque worker est fixé à un coeur, ses étoiles sont écrites pour
+ * la première fois par lui (Linux alloue une page sur le noeud du thread qui la touche en premier) et il parcourt une
+ * copie de l'arbre faite sur son noeud.
+ *
+ * Les threads sont répartis par blocs contigus, comme les parties de make_partitions : le thread t travaille sur le
+ * noeud t * nb_noeuds / n_thread. Les étoiles sont placées selon des parties de même nombre d'étoiles, les parties de
+ * même coût s'en écartent un peu : seules les étoiles proches des frontières sont lues à distance.
+ *
+ * Les blocs possèdent leurs enfants : la copie est celle de l'arbre entier, faite et remise à jour par un thread du
+ * noeud, fixé sur ses coeurs et gardé pendant toute la vie du placement. Les affectations suivantes réutilisent ses
+ * vecteurs, qui restent sur le noeud.
+ */
+class Numa_placement {
+
+public:
+
+	std::vector<Numa_node> nodes;   // Vide : placement désactivé
+	std::vector<Block> replicas;    // Copie de l'arbre pour chaque noeud sauf le premier (celui du thread principal)
+
+	Numa_placement() = default;
+
+	Numa_placement(const std::vector<Numa_node> &nodes, std::size_t n_thread);
+
+	virtual ~Numa_placement();
+
+	Numa_placement(const Numa_placement &placement) = delete; // Possède des threads
+
+	Numa_placement &operator=(const Numa_placement &placement) = delete;
+
+	[[nodiscard]] bool is_active() const;
+
+	/**
+	 * \brief Noeud d'un worker.
+	 * \param thread indice du worker
+	 * \return indice dans nodes
+	 */
+	[[nodiscard]] std::size_t node_of(std::size_t thread) const;
+
+	/**
+	 * \brief Fixe le thread appelant sur les coeurs du premier noeud (il construit l'arbre principal).
+	 */
+	void pin_main() const;
+
+	/**
+	 * \brief Fixe un worker à son coeur.
+	 * \param thread
+	 * \param index indice du worker
+	 */
+	void pin(std::thread &thread, std::size_t index) const;
+
+	/**
+	 * \brief Réécrit les étoiles depuis le worker qui les traitera, après avoir rendu leurs pages au système.
+	 * \param galaxy
+	 */
+	void first_touch(Star::container &galaxy) const;
+
+	/**
+	 * \brief Copie l'arbre tout juste construit sur chaque autre noeud.
+	 * \param block
+	 */
+	void replicate(const Block &block);
+
+	/**
+	 * \brief Remet à jour l'arbre et ses copies, chacune par un thread de son noeud.
+	 * \param block
+	 */
+	void refit(Block &block);
+
+	/**
+	 * \brief Arbre à parcourir par un worker.
+	 * \param block arbre principal
+	 * \param thread indice du worker
+	 * \return
+	 */
+	[[nodiscard]] const Block &tree(const Block &block, std::size_t thread) const;
+
+private:
+
+	// Thread fixé sur un noeud autre que le premier, réveillé par on_nodes
+	struct Node_helper {
+		std::thread thread;
+		std::mutex mutex;
+		std::condition_variable wake, finished;
+		const std::function<void(std::size_t)> *task{ nullptr };    // Tâche en cours (nullptr : aucune)
+		bool stop{ false };
+	};
+
+	std::size_t n_thread{ 1 };
+	std::vector<std::unique_ptr<Node_helper>> helpers;    // Un par noeud sauf le premier
+
+	[[nodiscard]] int worker_cpu(std::size_t index) const;
+
+	void on_nodes(const std::function<void(std::size_t)> &task) const;
+};
+
+#endif
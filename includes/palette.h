@@ -0,0 +1,77 @@
+#ifndef PALETTE_H
+#define PALETTE_H
+
+#include "star.h"
+#include "compute.h"
+
+/**
+ * \class Palette
+ * \brief Table de correspondance précalculée entre la densité et la couleur des étoiles.
+ *
+ * La table contient 768 entrées (3 dégradés de 256 couleurs), l'indice est obtenu en multipliant la densité par
+ * density_scale puis en le bornant à la dernière entrée : aucun branchement dans la boucle sur les étoiles.
+ */
+class Palette {
+
+public:
+
+	static constexpr std::size_t size = 768;
+
+	//! Couleurs de la table
+	std::array<glm::u8vec3, size> colors{};
+	//! Facteur multiplicatif appliqué à la densité pour obtenir l'indice dans la table
+	double density_scale{ 2. };
+
+	Palette() = default;
+
+	virtual ~Palette() = default;
+
+	/**
+	 * \brief Construit la table à partir d'un générateur.
+	 * \param generator fonction donnant la couleur de l'entrée i (0 <= i < size)
+	 * \param density_scale
+	 */
+	Palette(const std::function<glm::u8vec3(std::size_t)> &generator, const double &density_scale);
+
+	Palette(const Palette &palette) = default;
+
+	Palette &operator=(const Palette &palette) = default;
+
+	/**
+	 * \brief Indice dans la table correspondant à une densité.
+	 * \param density
+	 * \return
+	 */
+	[[nodiscard]] std::size_t index(const double &density) const;
+
+	/**
+	 * \brief Colore un tableau de densités.
+	 * \param densities
+	 * \param colors redimensionné à la taille de densities
+	 * \param compute
+	 */
+	void apply(const std::vector<double> &densities, std::vector<glm::u8vec3> &colors, const Compute &compute = Compute()) const;
+};
+
+enum Color_mode { density_colors, heat_colors, real_colors }; // Modes de coloration possibles
+
+/**
+ * \brief Dégradé noir, bleu, cyan puis blanc (coloration historique de la simulation).
+ * \return
+ */
+Palette blue_palette();
+
+/**
+ * \brief Dégradé noir, rouge, jaune puis blanc.
+ * \return
+ */
+Palette heat_palette();
+
+/**
+ * \brief Donne la palette associée à un mode de coloration.
+ * \param mode
+ * \return nullptr pour les couleurs réelles : la couleur fixée à la création de l'étoile est conservée.
+ */
+const Palette *select_palette(Color_mode mode);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include "vector.h"
+
+enum Perf_event { tlb_misses, page_faults }; // Évènements comptés (défauts du TLB de données en lecture, défauts de page)
+
+/**
+ * \class Perf_counter
+ * \brief Compte un évènement dans tout le processus avec perf_event_open (Linux) : le thread qui l'ouvre et ceux qu'il
+ * crée ensuite (à ouvrir avant les workers). Mode utilisateur seulement, autorisé avec perf_event_paranoid <= 2.
+ *
+ * Les défauts de TLB sont un compteur matériel : absent des machines virtuelles qui ne l'exposent pas, le compteur
+ * est alors indisponible.
+ */
+class Perf_counter {
+
+public:
+
+	Perf_counter() = default;
+
+	explicit Perf_counter(Perf_event event);
+
+	virtual ~Perf_counter();
+
+	Perf_counter(const Perf_counter &counter) = delete; // Possède un descripteur
+
+	Perf_counter &operator=(const Perf_counter &counter) = delete;
+
+	[[nodiscard]] bool is_available() const;
+
+	/**
+	 * \brief Évènements depuis la dernière lecture.
+	 * \return 0 si indisponible
+	 */
+	std::uint64_t read();
+
+private:
+
+	int descriptor{ -1 };
+	std::uint64_t last{ 0 };
+};
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef PM_H
+#define PM_H
+
+#include "block.h"
+#include <complex>
+
+/**
+ * \class Particle_mesh
+ * \brief Partie longue portée d'un calcul TreePM : méthode particule-maillage (PM) résolue par transformée de Fourier.
+ *
+ * Les masses sont déposées sur une grille cubique de grid_size^3 noeuds (nuage dans une cellule, CIC), le potentiel est
+ * la convolution de cette grille avec la fonction de Green longue portée -G erf(r / 2 r_s) / r, calculée par FFT sur
+ * une grille deux fois plus grande complétée de zéros (conditions isolées, pas de copies périodiques). L'accélération
+ * est obtenue par différences finies puis interpolée aux étoiles avec les mêmes poids CIC. Le reste de la force,
+ * G m (erfc(r / 2 r_s) + r / (r_s sqrt(pi)) exp(-r^2 / 4 r_s^2)) / r^2, est calculé par l'arbre jusqu'à cutoff * r_s.
+ *
+ * La FFT intégrée (radix 2) est remplacée par FFTW quand GALAXY_FFTW est défini (détection dans CMakeLists.txt).
+ */
+class Particle_mesh {
+
+public:
+
+	//! Rayon de coupure de la partie courte portée (en rayons de séparation r_s)
+	static constexpr double cutoff = 4.5;
+
+	Particle_mesh() = default;
+
+	/**
+	 * \brief Prépare la grille et la fonction de Green.
+	 * \param grid_size nombre de noeuds par côté (arrondi à une puissance de deux, 0 : solveur inactif)
+	 * \param split_cells rayon de séparation r_s (en cellules)
+	 */
+	Particle_mesh(std::size_t grid_size, const double &split_cells);
+
+	virtual ~Particle_mesh();
+
+	Particle_mesh(const Particle_mesh &mesh) = delete;
+
+	Particle_mesh &operator=(const Particle_mesh &mesh) = delete;
+
+	/**
+	 * \brief Calcule le champ longue portée de toutes les étoiles.
+	 * \param root racine de l'arbre : la grille couvre son cube (avec une marge pour la dérive pendant les sous-pas)
+	 * \param stars
+	 * \param compute
+	 */
+	void solve(const Block &root, const Star::range &stars, const Compute &compute);
+
+	/**
+	 * \brief Accélération longue portée interpolée en un point (après solve).
+	 * \param position
+	 * \return
+	 */
+	[[nodiscard]] glm::dvec3 acceleration(const glm::dvec3 &position) const;
+
+	/**
+	 * \brief Rayon de séparation r_s (en mètres) du dernier appel à solve, à transmettre au parcours de l'arbre.
+	 * \return
+	 */
+	[[nodiscard]] double get_split_radius() const;
+
+private:
+
+	std::size_t grid_size{ 0 };                     // Noeuds par côté de la grille des masses
+	std::size_t padded_size{ 0 };                   // Noeuds par côté de la grille de la FFT (2 * grid_size)
+	double split_cells{ 1.25 };
+	double cell_size{ 0. };
+	glm::dvec3 origin{ 0, 0, 0 };                   // Position du noeud (0, 0, 0)
+	std::vector<std::complex<double>> green;        // Transformée de la fonction de Green (en unités de grille, sans G / h)
+	std::vector<std::complex<double>> grid;         // Grille de la FFT
+	std::vector<std::complex<double>> twiddles;     // exp(-2 i pi k / padded_size)
+	std::vector<double> masses;                     // Dépôt CIC (grid_size^3)
+	std::vector<glm::dvec3> field;                  // Accélération aux noeuds (grid_size^3)
+#ifdef GALAXY_FFTW
+	void *forward_plan{ nullptr };
+	void *backward_plan{ nullptr };
+#endif
+
+	[[nodiscard]] std::size_t padded_index(std::size_t i, std::size_t j, std::size_t k) const;
+
+	[[nodiscard]] std::size_t grid_index(std::size_t i, std::size_t j, std::size_t k) const;
+
+	void locate(const glm::dvec3 &position, std::array<std::size_t, 3> &node, glm::dvec3 &fraction) const;
+
+	void transform(bool inverse, std::size_t extent, const Compute &compute);
+
+	void transform_line(std::complex<double> *line, bool inverse) const;
+
+	void deposit(const Star::range &stars, const Compute &compute);
+
+	void differentiate(const Compute &compute);
+};
+
+/**
+ * \brief Facteur appliqué à la force newtonienne pour n'en garder que la partie courte portée (TreePM).
+ * \param distance
+ * \param split_radius r_s
+ * \return erfc(r / 2 r_s) + r / (r_s sqrt(pi)) exp(-r^2 / 4 r_s^2)
+ */
+double short_range_factor(const double &distance, const double &split_radius);
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef POTENTIAL_H
+#define POTENTIAL_H
+
+#include "vector.h"
+
+enum Potential_profile { nfw_halo, hernquist_halo, logarithmic_halo, miyamoto_nagai_disk }; // Profils analytiques possibles
+
+/**
+ * \struct External_potential
+ * \brief Potentiel analytique fixe (halo de matière noire, disque) remplaçant des millions de particules.
+ *
+ * NFW : phi = -G mass ln(1 + r / scale) / r, mass = 4 pi rho_0 scale^3 (masse caractéristique).
+ * Hernquist : phi = -G mass / (r + scale).
+ * Logarithmique : phi = speed^2 / 2 ln(scale^2 + R^2 + z^2 / flattening^2), courbe de rotation plate à speed.
+ * Miyamoto-Nagai : phi = -G mass / sqrt(R^2 + (scale + sqrt(z^2 + height^2))^2), disque d'épaisseur height.
+ */
+struct External_potential {
+	Potential_profile profile{ hernquist_halo };
+	double mass{ 0. };                  // Masse (en kilogrammes), inutilisée par le halo logarithmique
+	double scale{ 0. };                 // Rayon caractéristique (en mètres) : r_s, a ou rayon de coeur
+	double height{ 0. };                // Miyamoto-Nagai : hauteur caractéristique b (en mètres)
+	double speed{ 0. };                 // Logarithmique : vitesse circulaire asymptotique (en mètres par seconde)
+	double flattening{ 1. };            // Logarithmique : aplatissement q selon z
+	glm::dvec3 center{ 0, 0, 0 };
+
+	/**
+	 * \brief Accélération en un point.
+	 * \param position
+	 * \return
+	 */
+	[[nodiscard]] glm::dvec3 acceleration(const glm::dvec3 &position) const;
+
+	/**
+	 * \brief Potentiel en un point (pour l'énergie).
+	 * \param position
+	 * \return
+	 */
+	[[nodiscard]] double potential(const glm::dvec3 &position) const;
+};
+
+/**
+ * \class External_field
+ * \brief Somme de potentiels analytiques, ajoutée à l'accélération calculée par le solveur.
+ */
+class External_field {
+
+public:
+
+	std::vector<External_potential> components;
+
+	External_field() = default;
+
+	explicit External_field(const std::vector<External_potential> &components);
+
+	virtual ~External_field() = default;
+
+	External_field(const External_field &field) = default;
+
+	External_field &operator=(const External_field &field) = default;
+
+	[[nodiscard]] bool empty() const;
+
+	[[nodiscard]] glm::dvec3 acceleration(const glm::dvec3 &position) const;
+
+	[[nodiscard]] double potential(const glm::dvec3 &position) const;
+};
+
+#endif
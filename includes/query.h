@@ -0,0 +1,72 @@
+#ifndef QUERY_H
+#define QUERY_H
+
+#include "block.h"
+
+/*
+ * Requêtes spatiales sur l'octree construit par create_blocks. Les requêtes ne font que lire l'arbre : plusieurs threads
+ * peuvent les lancer en même temps, tant qu'aucun ne reconstruit (create_blocks) ni ne met à jour (refit) l'arbre. Les
+ * cubes des blocs sont ceux de la construction : les résultats sont exacts si les étoiles n'ont pas bougé depuis, comme
+ * juste après create_blocks au début d'un pas.
+ */
+
+/**
+ * \struct Neighbour
+ * \brief Étoile trouvée par une requête et sa distance au point de la requête.
+ */
+struct Neighbour {
+	double distance2{ 0. };             // Distance au carré
+	const Star *star{ nullptr };
+
+	bool operator<(const Neighbour &other) const {
+		return distance2 < other.distance2;
+	}
+};
+
+/**
+ * \brief Étoiles à moins de radius d'un point.
+ * \param root
+ * \param center
+ * \param radius
+ * \param result complété (pas vidé), ordre quelconque
+ */
+void stars_in_radius(const Block &root, const glm::dvec3 &center, const double &radius, std::vector<Neighbour> &result);
+
+/**
+ * \brief k plus proches étoiles d'un point (l'étoile située au point comprise).
+ * \param root
+ * \param position
+ * \param k
+ * \param result remplacé par les voisins triés du plus proche au plus lointain (moins de k s'il y a moins d'étoiles)
+ */
+void nearest_stars(const Block &root, const glm::dvec3 &position, std::size_t k, std::vector<Neighbour> &result);
+
+/**
+ * \brief Étoiles contenues dans une boîte.
+ * \param root
+ * \param box
+ * \param result complété (pas vidé), ordre quelconque
+ */
+void stars_in_box(const Block &root, const Bounding_box &box, std::vector<const Star *> &result);
+
+/**
+ * \brief Lance stars_in_radius pour plusieurs points, une tâche du backend de calcul par point.
+ * \param root
+ * \param centers
+ * \param radius
+ * \param compute
+ * \return un résultat par point
+ */
+std::vector<std::vector<Neighbour>> stars_in_radius(const Block &root, const std::vector<glm::dvec3> &centers, const double &radius, const Compute &compute);
+
+/**
+ * \brief Lance nearest_stars pour plusieurs points, une tâche du backend de calcul par point.
+ * \param root
+ * \param positions
+ * \param k
+ * \param compute
+ * \return un résultat par point
+ */
+std::vector<std::vector<Neighbour>> nearest_stars(const Block &root, const std::vector<glm::dvec3> &positions, std::size_t k, const Compute &compute);
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "utils.h"
+#include "palette.h"
+#include "triple_buffer.h"
+
+/**
+ * \struct Snapshot
+ * \brief Copie de l'état des étoiles vivantes transmise au thread de rendu.
+ */
+struct Snapshot {
+	std::vector<glm::dvec3> positions;
+	std::vector<double> densities;
+	std::vector<glm::u8vec3> colors;
+	glm::dvec3 mass_center{ 0, 0, 0 };
+
+	/**
+	 * \brief Copie les étoiles vivantes (appelé par le thread de calcul quand les workers sont à l'arrêt).
+	 * \param alive_galaxy
+	 * \param mass_center
+	 * \param densities densités indexées par Star::index (nullptr : Star::density, sous-produit du calcul de la gravité)
+	 * \param compute
+	 */
+	void capture(const Star::range &alive_galaxy, const glm::dvec3 &mass_center, const std::vector<double> *densities = nullptr,
+				 const Compute &compute = Compute());
+};
+
+/**
+ * \brief Boucle du thread de rendu : possède la fenêtre SDL, gère les évènements et affiche le dernier snapshot publié.
+ * \param snapshots
+ * \param palette nullptr pour garder les couleurs réelles
+ * \param quit passe à true quand l'utilisateur ferme la fenêtre
+ * \param area
+ * \param zoom
+ * \param view
+ */
+void render_loop(Triple_buffer<Snapshot> &snapshots, const Palette *palette, std::atomic<bool> &quit,
+				 const double &area, const double &zoom, View view);
+
+/**
+ * \brief Affiche les étoiles d'un snapshot.
+ * \param snapshot
+ * \param colors couleur de chaque étoile du snapshot
+ * \param area
+ * \param zoom
+ * \param view
+ */
+void draw_stars(const Snapshot &snapshot, const std::vector<glm::u8vec3> &colors, const double &area, const double &zoom, View view);
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include "compute.h"
+#include "potential.h"
+
+/**
+ * \struct Galaxy_model
+ * \brief Une galaxie d'un scénario : disque généré (comme l'ancienne galaxie unique) ou étoiles lues dans un fichier,
+ * puis tournée, déplacée et lancée à sa vitesse d'ensemble.
+ *
+ * Orientation : rotation de inclination autour de l'axe x, puis de node autour de l'axe z (le disque est dans le plan xy
+ * avant rotation, sa rotation propre est dans le sens direct).
+ *
+ * Équilibre : v^2 = G M(< r) R^2 f(r^2) + R a_ext, avec M(< r) tirée d'un histogramme radial des masses de la galaxie
+ * (approximation sphérique), f le noyau d'adoucissement et a_ext l'accélération centripète du champ extérieur. Le disque
+ * démarre près de l'équilibre au lieu de s'effondrer ou de s'étaler.
+ */
+struct Galaxy_model {
+	int stars_number{ 0 };              // Nombre d'étoiles générées (ignoré si file est donné)
+	double area{ 0. };                  // Taille de la zone d'apparition des étoiles (en mètres)
+	double thickness{ 0.05 };           // Epaisseur du disque (en "area")
+	double initial_speed{ 0. };         // Vitesse de rotation des étoiles (en mètres par seconde), ignorée à l'équilibre
+	bool is_black_hole{ false };        // Trou noir au centre
+	double black_hole_mass{ 0. };       // Masse du trou noir (en masses solaires)
+	bool equilibrium{ false };          // Vitesses circulaires calculées à partir de la masse intérieure et du champ extérieur
+	double dispersion{ 0. };            // Équilibre : dispersion des vitesses (en fraction de la vitesse circulaire)
+	glm::dvec3 position{ 0, 0, 0 };     // Centre de la galaxie (en mètres)
+	glm::dvec3 speed{ 0, 0, 0 };        // Vitesse d'ensemble (en mètres par seconde)
+	double inclination{ 0. };           // Rotation autour de x (en radians)
+	double node{ 0. };                  // Rotation autour de z (en radians)
+	std::string file{};                 // Conditions initiales : une étoile par ligne "x y z vx vy vz masse" (années-lumière, m/s, masses solaires)
+};
+
+/**
+ * \brief Crée les étoiles de toutes les galaxies d'un scénario, directement à leur place dans le conteneur.
+ *
+ * La génération est répartie par paquets d'étoiles (une tâche du backend de calcul chacun), chacun avec son propre
+ * générateur initialisé à partir de seed et du numéro du paquet : le résultat ne dépend ni du backend ni du nombre de
+ * threads.
+ * \param galaxy conteneur rempli (son contenu précédent est remplacé)
+ * \param models
+ * \param seed
+ * \param compute
+ * \param external champ extérieur pris en compte par les galaxies à l'équilibre (nullptr : aucun)
+ * \return faux si un fichier n'a pas pu être lu
+ */
+bool create_scenario(Star::container &galaxy, const std::vector<Galaxy_model> &models, std::uint64_t seed, const Compute &compute,
+					 const External_field *external = nullptr);
+
+/**
+ * \brief Lit des conditions initiales (lignes vides et commençant par # ignorées).
+ * \param path
+ * \param stars étoiles ajoutées, dans le repère du fichier
+ * \return faux si le fichier n'existe pas ou contient une ligne invalide
+ */
+bool load_initial_conditions(const std::string &path, Star::container &stars);
+
+#endif
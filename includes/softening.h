@@ -0,0 +1,86 @@
+#ifndef SOFTENING_H
+#define SOFTENING_H
+
+#include "utils.h"
+
+/*
+ * Noyaux d'adoucissement de la gravité. Chaque noyau donne, pour une distance au carré d2 et une longueur
+ * d'adoucissement eps :
+ *   force(d2, eps)     : f tel que l'accélération due à une masse m vaut G m f (source - cible) (1 / r^3 sans adoucissement)
+ *   potential(d2, eps) : p tel que le potentiel vaut G m p (-1 / r sans adoucissement)
+ * Une distance nulle (l'étoile elle-même) ne donne aucune force. Le noyau est choisi à la compilation par l'alias
+ * Softening : les fonctions sont inlinées dans les boucles de tous les solveurs.
+ */
+
+/**
+ * \struct No_softening
+ * \brief Gravité newtonienne pure (comportement historique).
+ */
+struct No_softening {
+
+	static double force(const double &distance2, const double &) {
+		return distance2 > 0. ? 1. / (distance2 * std::sqrt(distance2)) : 0.;
+	}
+
+	static double potential(const double &distance2, const double &) {
+		return distance2 > 0. ? -1. / std::sqrt(distance2) : 0.;
+	}
+};
+
+/**
+ * \struct Plummer_softening
+ * \brief Chaque étoile est une sphère de Plummer de rayon eps : force en 1 / (r^2 + eps^2), jamais exactement newtonienne.
+ */
+struct Plummer_softening {
+
+	static double force(const double &distance2, const double &length) {
+		const double softened2 = distance2 + length * length;
+		return 1. / (softened2 * std::sqrt(softened2));
+	}
+
+	static double potential(const double &distance2, const double &length) {
+		return -1. / std::sqrt(distance2 + length * length);
+	}
+};
+
+/**
+ * \struct Spline_softening
+ * \brief Masse répartie selon la spline cubique de Monaghan de rayon h = 2.8 eps (même potentiel central que Plummer),
+ * force exactement newtonienne au-delà de h.
+ */
+struct Spline_softening {
+
+	static double force(const double &distance2, const double &length) {
+		const double h = 2.8 * length;
+
+		if (distance2 >= h * h)
+			return distance2 > 0. ? 1. / (distance2 * std::sqrt(distance2)) : 0.;
+
+		const double u = std::sqrt(distance2) / h;
+		const double inv_h3 = 1. / (h * h * h);
+
+		if (u < 0.5)
+			return inv_h3 * (10.666666666667 + u * u * (32. * u - 38.4));
+
+		return inv_h3 * (21.333333333333 - 48. * u + 38.4 * u * u - 10.666666666667 * u * u * u - 0.066666666667 / (u * u * u));
+	}
+
+	static double potential(const double &distance2, const double &length) {
+		const double h = 2.8 * length;
+
+		if (distance2 >= h * h)
+			return distance2 > 0. ? -1. / std::sqrt(distance2) : 0.;
+
+		const double u = std::sqrt(distance2) / h;
+
+		if (u < 0.5)
+			return (-2.8 + u * u * (5.333333333333 + u * u * (6.4 * u - 9.6))) / h;
+
+		return (-3.2 + 0.066666666667 / u + u * u * (10.666666666667 + u * (-16. + u * (9.6 - 2.133333333333 * u)))) / h;
+	}
+};
+
+using Softening = Spline_softening;                        // Noyau utilisé par tous les solveurs (No_softening, Plummer_softening ou Spline_softening)
+constexpr double SOFTENING_LENGTH = 1. * LIGHT_YEAR;       // Longueur d'adoucissement eps (en mètres)
+
+#endif
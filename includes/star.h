@@ -1,7 +1,7 @@
 #ifndef STAR_H
 #define STAR_H
 
-#include "vector.h"
+#include "arena.h"
 
 class Block;
 
@@ -13,15 +13,18 @@ class Star {
 
 public:
 
-	using container = std::vector<Star>; // Plus rapide : contigüe en mémoire.
+	using container = std::vector<Star, Arena_allocator<Star>>; // Plus rapide : contigüe en mémoire (pages choisies par set_page_mode).
+#ifdef GALAXY_COMPACT
+	using index_type = std::uint32_t;    // Mode compact : identifiants et positions sur 32 bits (4 milliards d'étoiles au plus)
+#else
+	using index_type = std::size_t;
+#endif
 
 	struct range {
 		container::iterator begin;
 		container::iterator end;
 	};
 
-	//! Position d'avant
-	glm::dvec3 previous_position{ 0, 0, 0 };
 	//! Position
 	glm::dvec3 position{ 0, 0, 0 };
 	//! La vitesse
@@ -35,17 +38,21 @@ public:
 	//! La couleur de l'étoile
 	glm::u8vec3 color{ 0, 0, 0 };
 	//! Indice de l'étoile
-	std::size_t index{ 0 };
-	//! Indice du bloc
-	std::size_t block_index{ 0 };
+	index_type index{ 0 };
+	//! Blocs visités au dernier parcours de l'arbre (coût de l'étoile pour la répartition entre threads)
+	std::uint32_t interactions{ 0 };
+	//! Niveau de pas de temps : l'étoile avance de step / 2^rung
+	std::uint8_t rung{ 0 };
 	//! Flag pour la prise en compte de l'étoile.
 	bool is_alive{ false };
 
 	Star() = default;
 
+#ifdef GALAXY_COMPACT
+	~Star() = default; // Pas de table virtuelle : un pointeur de moins par étoile
+#else
 	virtual ~Star() = default;
-
-	Star(const double &speed_initial, const double &area, const double &step, const double &galaxy_thickness);
+#endif
 
 	Star(const Star &star) = default;
 
@@ -55,24 +62,77 @@ public:
 
 	Star &operator=(Star &&star) = default;
 
-	void update_position(const double &step, bool verlet_integration);
+	void update_position(const double &step);
+
+	void update_speed(const double &step);
+
+	/**
+	 * \brief Calcule l'accélération et la densité par le parcours de l'arbre.
+	 * \param precision angle d'ouverture
+	 * \param block racine
+	 * \param quadrupole
+	 * \param split_radius TreePM : rayon de séparation r_s, seule la partie courte portée est calculée (0 : force complète)
+	 * \param prefetch_distance blocs demandés au cache autant de visites à l'avance (0 : aucun)
+	 * \param with_density false quand la densité vient d'ailleurs (plus proches voisins) : density reste nulle
+	 */
+	void update_acceleration_and_density(const double &precision, const Block &block, bool quadrupole, const double &split_radius = 0., std::size_t prefetch_distance = 0,
+										 bool with_density = true);
+
+	/**
+	 * \brief Choisit le niveau de pas de temps (puissance de deux) à partir de l'accélération.
+	 * \param step pas de temps le plus grand
+	 * \param max_rung niveau le plus fin
+	 * \param substep sous-pas courant : un pas plus grand n'est accepté que s'il commence ici
+	 * \param accuracy
+	 * \param length longueur caractéristique du critère sqrt(2 * accuracy * length / |acceleration|)
+	 */
+	void update_rung(const double &step, int max_rung, std::size_t substep, const double &accuracy, const double &length);
+};
 
-	void update_speed(const double &step, const double &area);
+/**
+ * \brief Nombre de sous-pas (de taille step / 2^max_rung) entre deux calculs de force pour un niveau.
+ * \param rung
+ * \param max_rung
+ * \return
+ */
+std::size_t rung_period(int rung, int max_rung);
 
-	void update_acceleration_and_density(const double &precision, const Block &block);
+/**
+ * \brief Retire les étoiles sorties de la partie vivante en les échangeant avec la dernière étoile vivante.
+ * \param galaxy
+ * \param alive_galaxy fin avancée d'autant d'étoiles que de positions dans escaped
+ * \param escaped positions dans galaxy des étoiles sorties (triées par la fonction)
+ * \param slots table identifiant -> position, mise à jour pour les étoiles déplacées
+ */
+void remove_escaped(Star::container &galaxy, Star::range &alive_galaxy, std::vector<std::size_t> &escaped, std::vector<Star::index_type> &slots);
 
-	void update_color();
-};
+/**
+ * \brief Demande le chargement en cache des lignes d'un objet, sans attendre : le calcul continue pendant l'accès à la
+ * mémoire (sans effet hors GCC et Clang).
+ * \param object
+ */
+template<typename T>
+inline void prefetch([[maybe_unused]] const T &object) {
+#if defined(__GNUC__) || defined(__clang__)
+	const auto begin = reinterpret_cast<std::uintptr_t>(&object);
 
-glm::dvec3 force_and_density_calculation(const double &precision, Star &star, const Block &block);
+	for (auto line = begin & ~std::uintptr_t{ 63 }; line < begin + sizeof(T); line += 64)
+		__builtin_prefetch(reinterpret_cast<const void *>(line), 0, 3);
+#endif
+}
 
-void initialize_galaxy(Star::container &galaxy,
-					   int stars_number,
-					   const double &area,
-					   const double &initial_speed,
-					   const double &step,
-					   bool is_black_hole,
-					   const double &black_hole_mass,
-					   const double &galaxy_thickness);
+/**
+ * \brief Parcourt l'arbre (en profondeur, pile explicite) pour la force exercée sur une étoile et sa densité.
+ * \param precision angle d'ouverture
+ * \param star
+ * \param block racine
+ * \param quadrupole
+ * \param split_radius TreePM : rayon de séparation (0 : force complète)
+ * \param prefetch_distance le bloc qui sera visité autant de visites plus tard est demandé au cache (0 : aucun)
+ * \param with_density false : la densité n'est pas accumulée
+ * \return force divisée par la masse de l'étoile
+ */
+glm::dvec3 force_and_density_calculation(const double &precision, Star &star, const Block &block, bool quadrupole, const double &split_radius = 0., std::size_t prefetch_distance = 0,
+										 bool with_density = true);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,98 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include "vector.h"
+#include <memory>
+
+/**
+ * \class Transport
+ * \brief Communication entre les rangs (processus) d'une simulation décomposée en domaines.
+ *
+ * Une seule opération collective, sur le modèle de MPI_Alltoallv : chaque rang donne un message par rang et reçoit un
+ * message de chaque rang. Tous les rangs doivent l'appeler dans le même ordre. Les autres opérations (réunion, somme,
+ * diffusion) s'écrivent avec elle dans Domain : une autre implémentation (MPI, mémoire partagée) n'a que ceci à fournir.
+ */
+class Transport {
+
+public:
+
+	Transport() = default;
+
+	virtual ~Transport() = default;
+
+	Transport(const Transport &transport) = delete;
+
+	Transport &operator=(const Transport &transport) = delete;
+
+	[[nodiscard]] virtual std::size_t rank() const = 0;
+
+	[[nodiscard]] virtual std::size_t size() const = 0;
+
+	/**
+	 * \brief Échange tout-à-tous.
+	 * \param messages messages[r] est envoyé au rang r (size() messages, celui du rang courant lui revient)
+	 * \return message reçu de chaque rang
+	 */
+	virtual std::vector<std::vector<char>> exchange(const std::vector<std::vector<char>> &messages) = 0;
+};
+
+/**
+ * \class Local_transport
+ * \brief Un seul rang : pas de décomposition.
+ */
+class Local_transport : public Transport {
+
+public:
+
+	[[nodiscard]] std::size_t rank() const override;
+
+	[[nodiscard]] std::size_t size() const override;
+
+	std::vector<std::vector<char>> exchange(const std::vector<std::vector<char>> &messages) override;
+};
+
+/**
+ * \class Socket_transport
+ * \brief Rangs lancés comme processus sur la même machine (fork), reliés deux à deux par des paires de sockets.
+ *
+ * Remplace MPI pour développer et tester la décomposition sans grappe de calcul. Les envois et réceptions sont non
+ * bloquants (poll) : les gros messages de tous les rangs avancent ensemble sans interblocage.
+ */
+class Socket_transport : public Transport {
+
+public:
+
+	/**
+	 * \brief Relie le rang courant aux autres.
+	 * \param rank
+	 * \param sockets socket vers chaque rang (-1 pour le rang courant)
+	 * \param children processus fils, attendus par le destructeur (rang 0)
+	 */
+	Socket_transport(std::size_t rank, std::vector<int> sockets, std::vector<int> children);
+
+	~Socket_transport() override;
+
+	[[nodiscard]] std::size_t rank() const override;
+
+	[[nodiscard]] std::size_t size() const override;
+
+	std::vector<std::vector<char>> exchange(const std::vector<std::vector<char>> &messages) override;
+
+private:
+
+	std::size_t current_rank;
+	std::vector<int> sockets;
+	std::vector<int> children;
+};
+
+/**
+ * \brief Lance les rangs : le processus est dupliqué nb_ranks - 1 fois et chaque copie reçoit son transport.
+ *
+ * À appeler avant la création de tout thread (seul le thread appelant existe dans les processus fils). Sous Windows, ou
+ * si nb_ranks vaut 1, renvoie un Local_transport.
+ * \param nb_ranks
+ * \return
+ */
+std::unique_ptr<Transport> launch_ranks(std::size_t nb_ranks);
+
+#endif
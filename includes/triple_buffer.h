@@ -0,0 +1,74 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * \class Triple_buffer
+ * \brief Échange sans verrou entre un producteur et un consommateur.
+ *
+ * Le producteur écrit dans back() puis publie, le consommateur récupère le dernier tampon publié avec update() et lit
+ * front(). Aucun des deux n'attend l'autre : un tampon publié mais jamais lu est simplement remplacé par le suivant.
+ */
+template<typename T>
+class Triple_buffer {
+
+public:
+
+	Triple_buffer() = default;
+
+	virtual ~Triple_buffer() = default;
+
+	Triple_buffer(const Triple_buffer &buffer) = delete;
+
+	Triple_buffer &operator=(const Triple_buffer &buffer) = delete;
+
+	/**
+	 * \brief Tampon en cours d'écriture (producteur uniquement).
+	 * \return
+	 */
+	T &back() {
+		return buffers[back_index];
+	}
+
+	/**
+	 * \brief Publie le tampon écrit et en récupère un libre (producteur uniquement).
+	 */
+	void publish() {
+		back_index = middle.exchange(back_index | fresh, std::memory_order_acq_rel) & index_mask;
+	}
+
+	/**
+	 * \brief Récupère le dernier tampon publié s'il y en a un nouveau (consommateur uniquement).
+	 * \return true si front() a changé
+	 */
+	bool update() {
+		if (!(middle.load(std::memory_order_relaxed) & fresh))
+			return false;
+
+		front_index = middle.exchange(front_index, std::memory_order_acq_rel) & index_mask;
+		return true;
+	}
+
+	/**
+	 * \brief Dernier tampon récupéré (consommateur uniquement).
+	 * \return
+	 */
+	const T &front() const {
+		return buffers[front_index];
+	}
+
+private:
+
+	static constexpr std::uint8_t index_mask = 3; // Les deux bits de poids faible donnent l'indice du tampon
+	static constexpr std::uint8_t fresh = 4;      // Le tampon du milieu n'a pas encore été lu
+
+	std::array<T, 3> buffers;
+	std::atomic<std::uint8_t> middle{ 1 };
+	std::uint8_t back_index{ 0 };
+	std::uint8_t front_index{ 2 };
+};
+
+#endif
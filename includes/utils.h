@@ -26,10 +26,4 @@ enum View { default_view, xy, xz, yz }; // Vues possibles de la simulation
 
 extern SDL_Renderer *renderer;
 
-int random_int(const int &min, const int &max);
-
-double random_double(const double &min, const double &max);
-
-void draw_stars(Star::range &alive_galaxy, const glm::dvec3 &mass_center, const double &area, const double &zoom, View view);
-
 #endif
\ No newline at end of file
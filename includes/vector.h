@@ -2,16 +2,26 @@
 #define VECTOR_H
 
 #include <cmath>
+#include <cstdint>
 #include <vector>
 #include <list>
 #include <algorithm>
+#include <numeric>
 #include <fstream>
 #include <thread>
 #include <atomic>
 #include <variant>
 #include <iostream>
+#include <iomanip>
 #include <array>
 #include <functional>
+#include <limits>
+#include <string>
+#include <sstream>
+#include <random>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
 
 
 #define GLM_FORCE_INLINE
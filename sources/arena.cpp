@@ -0,0 +1,302 @@
+#include "arena.h"
+#include <mutex>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static constexpr std::size_t huge_page = std::size_t{ 2 } << 20;       // Taille d'une grande page (x86-64)
+static constexpr std::size_t small_limit = 4096;                        // Jusque-là, classes de 64 en 64 octets
+static constexpr std::size_t large_limit = std::size_t{ 1 } << 20;     // Au-delà, projection directe
+static constexpr std::size_t nb_classes = small_limit / 64 + 8;         // 64 classes fines puis 8 puissances de deux (8 Ko à 1 Mo)
+static constexpr std::size_t batch_bytes = std::size_t{ 64 } << 10;    // Octets pris d'un coup par une liste libre vide
+
+struct Free_chunk {
+	Free_chunk *next;
+};
+
+// Plage de grandes pages en cours de découpe et blocs rendus par les threads terminés
+struct Shared_pool {
+	std::mutex mutex;
+	std::array<Free_chunk *, nb_classes> lists{};
+	char *slab{ nullptr };
+	std::size_t left{ 0 };
+	std::size_t nb_slabs{ 0 };
+};
+
+static std::atomic<Page_mode> page_mode{ standard_pages };
+static std::atomic<bool> has_allocated{ false };
+
+// Pool partagé, jamais détruit : des conteneurs peuvent être libérés pendant la destruction des objets statiques
+
+static Shared_pool &shared_pool() {
+	static auto *pool = new Shared_pool;
+	return *pool;
+}
+
+
+
+// Classe de taille d'une allocation
+
+static std::size_t class_of(std::size_t bytes) {
+	if (bytes <= small_limit)
+		return (std::max<std::size_t>(bytes, 1) + 63) / 64 - 1;
+
+	std::size_t c = small_limit / 64;
+	for (std::size_t size = 2 * small_limit; size < bytes; size *= 2)
+		++c;
+
+	return c;
+}
+
+
+
+// Taille des blocs d'une classe
+
+static std::size_t class_size(std::size_t c) {
+	if (c < small_limit / 64)
+		return (c + 1) * 64;
+
+	return small_limit << (c - small_limit / 64 + 1);
+}
+
+
+
+// Projette des pages (taille multiple de 2 Mo), en grandes pages si le mode le demande
+
+static void *map_pages([[maybe_unused]] std::size_t bytes, [[maybe_unused]] Page_mode mode) {
+#ifdef __linux__
+	if (mode == hugetlbfs_pages) {
+		void *pointer = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+		if (pointer != MAP_FAILED)
+			return pointer;
+
+		static std::once_flag warning;
+		std::call_once(warning, []() {
+			std::cerr << "Grandes pages réservées épuisées ou absentes (vm.nr_hugepages) : grandes pages transparentes" << std::endl;
+		});
+	}
+
+	// Une grande page de plus, puis début et fin rendus : adresse alignée sur 2 Mo, seule condition des pages transparentes
+	const std::size_t padded = bytes + huge_page;
+	void *raw = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (raw == MAP_FAILED)
+		throw std::bad_alloc();
+
+	auto *begin = static_cast<char *>(raw);
+	auto *aligned = begin + (huge_page - reinterpret_cast<std::uintptr_t>(begin) % huge_page) % huge_page;
+
+	if (aligned > begin)
+		munmap(begin, static_cast<std::size_t>(aligned - begin));
+
+	if (aligned + bytes < begin + padded)
+		munmap(aligned + bytes, static_cast<std::size_t>(begin + padded - (aligned + bytes)));
+
+	madvise(aligned, bytes, MADV_HUGEPAGE);
+	return aligned;
+#else
+	return ::operator new(bytes);
+#endif
+}
+
+
+
+// Rend des pages projetées
+
+static void unmap_pages(void *pointer, [[maybe_unused]] std::size_t bytes) {
+#ifdef __linux__
+	munmap(pointer, bytes);
+#else
+	::operator delete(pointer);
+#endif
+}
+
+
+
+// Nombre de blocs d'une classe échangés d'un coup entre un thread et le pool partagé
+
+static std::size_t batch_count(std::size_t c) {
+	return std::max<std::size_t>(batch_bytes / class_size(c), 1);
+}
+
+
+
+// Prend un lot de blocs d'une classe : d'abord ceux rendus, puis la plage en cours
+
+static Free_chunk *refill(std::size_t c, Page_mode mode) {
+	const std::size_t size = class_size(c);
+	const std::size_t count = batch_count(c);
+	auto &pool = shared_pool();
+	std::lock_guard lock(pool.mutex);
+	Free_chunk *list = nullptr;
+
+	for (std::size_t i = 0; i < count; ++i) {
+		Free_chunk *chunk = pool.lists[c];
+
+		if (chunk)
+			pool.lists[c] = chunk->next;
+		else {
+			if (pool.left < size) { // Le reste de la plage précédente est plus petit qu'un bloc de cette classe
+				pool.slab = static_cast<char *>(map_pages(huge_page, mode));
+				pool.left = huge_page;
+				++pool.nb_slabs;
+			}
+
+			chunk = reinterpret_cast<Free_chunk *>(pool.slab);
+			pool.slab += size;
+			pool.left -= size;
+		}
+
+		chunk->next = list;
+		list = chunk;
+	}
+
+	return list;
+}
+
+
+
+// Listes libres d'un thread : l'excédent est rendu au pool partagé, tout le reste quand le thread se termine
+
+struct Thread_cache {
+	std::array<Free_chunk *, nb_classes> lists{};
+	std::array<std::size_t, nb_classes> counts{};
+
+	~Thread_cache() {
+		for (std::size_t c = 0; c < nb_classes; ++c)
+			give_back(c, counts[c]);
+	}
+
+	// Rend les count premiers blocs d'une classe au pool partagé
+
+	void give_back(std::size_t c, std::size_t count) {
+		auto &pool = shared_pool();
+		std::lock_guard lock(pool.mutex);
+
+		for (; count > 0 && lists[c]; --count) {
+			Free_chunk *chunk = lists[c];
+			lists[c] = chunk->next;
+			chunk->next = pool.lists[c];
+			pool.lists[c] = chunk;
+			--counts[c];
+		}
+	}
+};
+
+static thread_local Thread_cache cache;
+
+// Choisit les pages des allocations suivantes
+
+void set_page_mode(Page_mode mode) {
+#ifndef __linux__
+	mode = standard_pages;
+#endif
+
+	if (has_allocated && mode != page_mode) { // Les blocs déjà alloués seraient rendus au mauvais endroit
+		std::cerr << "Mode de pages choisi après les premières allocations : ignoré" << std::endl;
+		return;
+	}
+
+	page_mode = mode;
+}
+
+
+
+// Alloue de la mémoire selon le mode de pages
+
+void *arena_allocate(std::size_t bytes) {
+	const Page_mode mode = page_mode;
+	has_allocated = true;
+
+	if (mode == standard_pages)
+		return ::operator new(bytes);
+
+	if (bytes > large_limit)
+		return map_pages((bytes + huge_page - 1) / huge_page * huge_page, mode);
+
+	const std::size_t c = class_of(bytes);
+
+	if (!cache.lists[c]) {
+		cache.lists[c] = refill(c, mode);
+		cache.counts[c] = batch_count(c);
+	}
+
+	Free_chunk *chunk = cache.lists[c];
+	cache.lists[c] = chunk->next;
+	--cache.counts[c];
+	return chunk;
+}
+
+
+
+// Libère une allocation : dans la liste du thread appelant pour les petites, qui rend son excédent au pool partagé
+// (l'arbre est libéré par le thread principal et reconstruit par ceux des backends à tâches)
+
+void arena_deallocate(void *pointer, std::size_t bytes) {
+	if (page_mode == standard_pages) {
+		::operator delete(pointer);
+		return;
+	}
+
+	if (bytes > large_limit) {
+		unmap_pages(pointer, (bytes + huge_page - 1) / huge_page * huge_page);
+		return;
+	}
+
+	const std::size_t c = class_of(bytes);
+	auto *chunk = static_cast<Free_chunk *>(pointer);
+	chunk->next = cache.lists[c];
+	cache.lists[c] = chunk;
+
+	if (++cache.counts[c] > 2 * batch_count(c))
+		cache.give_back(c, batch_count(c));
+}
+
+
+
+// Plages de 2 Mo découpées pour les petites allocations
+
+std::size_t arena_slabs() {
+	auto &pool = shared_pool();
+	std::lock_guard lock(pool.mutex);
+	return pool.nb_slabs;
+}
+
+
+
+// Taille des pages des allocations
+
+std::size_t arena_page_size() {
+	if (page_mode != standard_pages)
+		return huge_page;
+
+#ifdef __linux__
+	return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#else
+	return 4096;
+#endif
+}
+
+
+
+// Mémoire servie en grandes pages
+
+std::size_t huge_page_bytes() {
+	std::ifstream file("/proc/self/smaps_rollup");
+	std::string line;
+	std::size_t bytes = 0;
+
+	while (std::getline(file, line)) {
+		std::istringstream stream(line);
+		std::string field;
+		std::size_t kilobytes = 0;
+
+		if (stream >> field >> kilobytes && (field == "AnonHugePages:" || field == "Private_Hugetlb:" || field == "Shared_Hugetlb:"))
+			bytes += kilobytes << 10;
+	}
+
+	return bytes;
+}
@@ -1,7 +1,16 @@
 #include "block.h"
+#include "utils.h"
 
+#ifdef GALAXY_COMPACT
+static constexpr double moment_unit = SOLAR_MASS * LIGHT_YEAR * LIGHT_YEAR; // En kg m², un quadripôle dépasse le plus grand float
+#else
+static constexpr double moment_unit = 1.;
+#endif
 
-std::array<Star::range, 8> set_octree(Star::range stars, glm::dvec3 pivot) {
+
+// Répartit les étoiles entre les 8 octants autour d'un pivot
+
+std::array<Star::range, 8> set_octree(Star::range stars, glm::dvec3 pivot, const Compute &compute) {
 	const std::array<std::function<bool(const Star &star)>, 3> testStarAxis{
 			[&pivot](const Star &star) { return star.position.x < pivot.x; }, // 3 double c'est plus lourd qu'une référence.
 			[&pivot](const Star &star) { return star.position.y < pivot.y; },
@@ -10,15 +19,15 @@ std::array<Star::range, 8> set_octree(Star::range stars, glm::dvec3 pivot) {
 
 	std::array<Star::range, 8> result;
 	std::size_t iPart = 0;
-	auto itX = std::partition(stars.begin, stars.end, testStarAxis[0]);
+	auto itX = compute.partition(stars, testStarAxis[0]);
 	auto xParts = std::array{ Star::range{ stars.begin, itX }, Star::range{ itX, stars.end }};
 
 	for (auto &part : xParts) {
-		auto itY = std::partition(part.begin, part.end, testStarAxis[1]);
+		auto itY = compute.partition(part, testStarAxis[1]);
 		auto yParts = std::array{ Star::range{ part.begin, itY }, Star::range{ itY, part.end }};
 
 		for (auto &part : yParts) {
-			auto itZ = std::partition(part.begin, part.end, testStarAxis[2]);
+			auto itZ = compute.partition(part, testStarAxis[2]);
 			result[iPart++] = Star::range{ part.begin, itZ };
 			result[iPart++] = Star::range{ itZ, part.end };
 		}
@@ -77,13 +86,14 @@ void Block::update_mass_center_and_mass(const Star::range &galaxy) {
 
 // Divise un bloc en 8 plus petits
 
-void Block::divide(Star::range stars) {
+void Block::divide(Star::range stars, const Compute &compute) {
 	if (stars.begin == stars.end) // pas d'etoile
 	{
 		contains = stars.begin; // pas tr�s utile, permet de clear la memoire de array<Block, 8> si c'�tait sa valeur pr�c�dente
 		nb_stars = 0;
 		mass = 0.;
 		mass_center = { 0., 0., 0. };
+		quadrupole = {};
 		as_children = false;
 	} else if (std::next(stars.begin) == stars.end) // une étoile
 	{
@@ -91,18 +101,18 @@ void Block::divide(Star::range stars) {
 		nb_stars = 1;
 		mass = stars.begin->mass;
 		mass_center = stars.begin->position;
+		quadrupole = {};
 		as_children = false;
 	} else {
 		if (contains.index() != 1)
-			contains = std::vector<Block>(8);
+			contains = container(8);
 
 		nb_stars = std::distance(stars.begin, stars.end);
 		as_children = true;
 
 		Block block;
 
-		block.as_parents = true;
-		block.set_size(halfsize);
+		block.set_size(size * 0.5);
 
 		const glm::dvec3 posis[] =
 				{
@@ -117,7 +127,7 @@ void Block::divide(Star::range stars) {
 				};
 
 		auto &myblocks = std::get<1>(contains);
-		auto partitions_stars = set_octree(stars, position);
+		auto partitions_stars = set_octree(stars, position, compute);
 		double new_mass = 0.;
 		auto new_mass_center = glm::dvec3(0., 0., 0.);
 		std::size_t i_add = 0;
@@ -125,8 +135,18 @@ void Block::divide(Star::range stars) {
 		for (std::size_t ibloc = 0; ibloc < 8; ++ibloc) {
 			myblocks[ibloc] = block;
 			myblocks[ibloc].position = posis[ibloc];
-			myblocks[ibloc].divide(partitions_stars[ibloc]);
+		}
 
+		// Sous-arbres indépendants : une tâche chacun tant qu'ils sont assez grands
+		if (compute.is_nested(nb_stars))
+			compute.tasks(8, [&myblocks, &partitions_stars, &compute](std::size_t ibloc) {
+				myblocks[ibloc].divide(partitions_stars[ibloc], compute);
+			});
+		else
+			for (std::size_t ibloc = 0; ibloc < 8; ++ibloc)
+				myblocks[ibloc].divide(partitions_stars[ibloc], compute);
+
+		for (std::size_t ibloc = 0; ibloc < 8; ++ibloc) {
 			if (myblocks[ibloc].nb_stars > 0) {
 				new_mass += myblocks[ibloc].mass;
 				new_mass_center += myblocks[ibloc].mass_center * myblocks[ibloc].mass;
@@ -136,7 +156,86 @@ void Block::divide(Star::range stars) {
 
 		mass = new_mass;
 		mass_center = new_mass_center / new_mass;
+		update_quadrupole();
+	}
+}
+
+
+
+// Côté du plus petit cube centré sur center qui contient le cube de côté size centré sur point
+
+static double covering_size(const glm::dvec3 &center, const glm::dvec3 &point, const double &size) {
+	return 2. * std::max({ std::abs(point.x - center.x), std::abs(point.y - center.y), std::abs(point.z - center.z) }) + size;
+}
+
+
+
+// Recalcule les centres de gravité de l'arbre existant (entre deux sous-pas, sans nouvelle partition)
+
+void Block::refit() {
+	if (nb_stars == 1) {
+		mass_center = std::get<0>(contains)->position;
+		size = std::max(size, covering_size(position, mass_center, 0.)); // L'étoile a pu sortir du bloc
+		return;
+	}
+
+	if (!as_children)
+		return;
+
+	auto new_mass_center = glm::dvec3(0., 0., 0.);
+
+	for (auto &child : std::get<1>(contains)) {
+		if (child.nb_stars > 0) {
+			child.refit();
+			new_mass_center += child.mass_center * child.mass;
+			size = std::max(size, covering_size(position, child.position, child.size));
+		}
 	}
+
+	mass_center = new_mass_center / mass;
+	update_quadrupole();
+}
+
+
+
+// Recalcule le moment quadripolaire : somme des moments des enfants déplacés au centre de gravité du bloc
+
+void Block::update_quadrupole() {
+	std::array<double, 6> moment{}; // Somme en double précision, convertie en moment_type à la fin
+
+	for (const auto &child : std::get<1>(contains)) {
+		if (child.nb_stars == 0)
+			continue;
+
+		const auto d = child.mass_center - mass_center;
+		const double d2 = glm::dot(d, d);
+
+		moment[0] += child.quadrupole[0] * moment_unit + child.mass * (3. * d.x * d.x - d2);
+		moment[1] += child.quadrupole[1] * moment_unit + child.mass * 3. * d.x * d.y;
+		moment[2] += child.quadrupole[2] * moment_unit + child.mass * 3. * d.x * d.z;
+		moment[3] += child.quadrupole[3] * moment_unit + child.mass * (3. * d.y * d.y - d2);
+		moment[4] += child.quadrupole[4] * moment_unit + child.mass * 3. * d.y * d.z;
+		moment[5] += child.quadrupole[5] * moment_unit + child.mass * (3. * d.z * d.z - d2);
+	}
+
+	for (std::size_t i = 0; i < moment.size(); ++i)
+		quadrupole[i] = static_cast<moment_type>(moment[i] / moment_unit);
+}
+
+
+
+// Accélération due au moment quadripolaire : G (Q r / r^5 - 5/2 (r.Q.r) r / r^7)
+
+glm::dvec3 quadrupole_acceleration(const Block &block, const glm::dvec3 &star_to_mass, const double &distance) {
+	const auto &q = block.quadrupole;
+	const auto &r = star_to_mass;
+	const glm::dvec3 qr(q[0] * r.x + q[1] * r.y + q[2] * r.z,
+						q[1] * r.x + q[3] * r.y + q[4] * r.z,
+						q[2] * r.x + q[4] * r.y + q[5] * r.z);
+	const double inv_r2 = 1. / (distance * distance);
+	const double inv_r5 = inv_r2 * inv_r2 / distance;
+
+	return (qr - r * (2.5 * glm::dot(r, qr) * inv_r2)) * (G * moment_unit * inv_r5);
 }
 
 
@@ -145,24 +244,87 @@ void Block::divide(Star::range stars) {
 
 void Block::set_size(const double &size) {
 	this->size = size;
-	this->halfsize = size * 0.5;
 }
 
 
 
-// Dit si l'�toile est dans le bloc
+// Agrandit la boîte pour contenir un point
+
+void Bounding_box::extend(const glm::dvec3 &point) {
+	min = { std::min(min.x, point.x), std::min(min.y, point.y), std::min(min.z, point.z) };
+	max = { std::max(max.x, point.x), std::max(max.y, point.y), std::max(max.z, point.z) };
+}
+
+
+
+// Agrandit la boîte pour contenir une autre boîte
+
+void Bounding_box::merge(const Bounding_box &box) {
+	min = { std::min(min.x, box.min.x), std::min(min.y, box.min.y), std::min(min.z, box.min.z) };
+	max = { std::max(max.x, box.max.x), std::max(max.y, box.max.y), std::max(max.z, box.max.z) };
+}
+
+
+
+// Dit si la boîte ne contient aucun point
+
+bool Bounding_box::is_empty() const {
+	return min.x > max.x;
+}
+
+
+
+// Calcule la boîte englobante d'un ensemble d'étoiles (réduction parallèle)
+
+Bounding_box bounding_box(const Star::range &stars, const Compute &compute) {
+	const auto count = static_cast<std::size_t>(std::distance(stars.begin, stars.end));
+
+	return compute.reduce(count, Bounding_box(), [&stars](std::size_t begin, std::size_t end) {
+		Bounding_box box;
+
+		for (auto it = stars.begin + begin; it != stars.begin + end; ++it)
+			box.extend(it->position);
 
-bool is_in(const Block &block, const Star &star) {
-	return (block.position.x + block.size * 0.5 > star.position.x and block.position.x - block.size * 0.5 < star.position.x
-			and block.position.y + block.size * 0.5 > star.position.y and block.position.y - block.size * 0.5 < star.position.y
-			and block.position.z + block.size * 0.5 > star.position.z and block.position.z - block.size * 0.5 < star.position.z);
+		return box;
+	}, [](Bounding_box box, const Bounding_box &other) {
+		box.merge(other);
+		return box;
+	});
+}
+
+
+
+// Mémoire allouée pour un arbre : les vecteurs d'enfants comptent leur capacité
+
+std::size_t tree_memory(const Block &block) {
+	std::size_t bytes = sizeof(Block);
+
+	if (block.contains.index() == 1) {
+		const auto &children = std::get<1>(block.contains);
+		bytes += (children.capacity() - children.size()) * sizeof(Block);
+
+		for (const auto &child : children)
+			bytes += tree_memory(child);
+	}
+
+	return bytes;
 }
 
 
 
 // G�n�re les blocs
 
-void create_blocks(const double &area, Block &block, Star::range &alive_galaxy) {
-	block.set_size(area * 3.);
-	block.divide(alive_galaxy);
+void create_blocks(const Bounding_box &box, Block &block, Star::range &alive_galaxy, const Compute &compute) {
+	if (box.is_empty()) {
+		block.set_size(0.);
+		block.divide(alive_galaxy, compute);
+		return;
+	}
+
+	const auto extent = box.max - box.min;
+
+	// Légère marge : les étoiles sur les faces de la boîte restent strictement à l'intérieur de la racine.
+	block.position = (box.min + box.max) * 0.5;
+	block.set_size(std::max({ extent.x, extent.y, extent.z }) * 1.001);
+	block.divide(alive_galaxy, compute);
 }
\ No newline at end of file
@@ -0,0 +1,319 @@
+#include "compute.h"
+
+#ifdef GALAXY_PARALLEL_STL
+#include <execution>
+#endif
+
+#ifdef GALAXY_OPENMP
+#include <omp.h>
+#endif
+
+static thread_local const Thread_pool *running_pool = nullptr; // Pool dont le thread exécute un lot
+
+// Lance les threads du pool
+
+Thread_pool::Thread_pool(std::size_t n_worker) {
+	for (std::size_t i = 0; i < n_worker; ++i)
+		workers.emplace_back(&Thread_pool::worker_loop, this);
+}
+
+
+
+// Arrête les threads du pool
+
+Thread_pool::~Thread_pool() {
+	{
+		std::lock_guard lock(mutex);
+		stop = true;
+	}
+
+	wake.notify_all();
+
+	for (auto &worker : workers)
+		worker.join();
+}
+
+
+
+// Exécute un lot de tâches et attend sa fin
+
+bool Thread_pool::run(std::size_t count, const std::function<void(std::size_t)> &task) {
+	if (running_pool == this)
+		return false;
+
+	std::lock_guard submitting(submit);
+	running_pool = this;
+	Job current;
+	current.task = &task;
+	current.count = count;
+
+	{
+		std::lock_guard lock(mutex);
+		job = &current;
+		++generation;
+	}
+
+	wake.notify_all();
+	current.work();
+
+	// Toutes les tâches sont prises : reste à attendre les threads qui finissent les leurs
+	{
+		std::unique_lock lock(mutex);
+		finished.wait(lock, [this]() { return active == 0; });
+		job = nullptr; // Un thread réveillé en retard ne trouve plus de lot
+	}
+
+	running_pool = nullptr;
+	return true;
+}
+
+
+
+// Prend les tâches du lot une à une
+
+void Thread_pool::Job::work() {
+	for (std::size_t i = next++; i < count; i = next++)
+		(*task)(i);
+}
+
+
+
+// Boucle d'un thread du pool : attend un lot, y participe, recommence
+
+void Thread_pool::worker_loop() {
+	running_pool = this;
+	std::unique_lock lock(mutex);
+	std::uint64_t seen = generation;
+
+	while (true) {
+		wake.wait(lock, [this, &seen]() { return stop || generation != seen; });
+
+		if (stop)
+			return;
+
+		seen = generation;
+		Job *current = job;
+
+		if (!current)
+			continue;
+
+		++active;
+		lock.unlock();
+		current->work();
+		lock.lock();
+
+		if (--active == 0)
+			finished.notify_all();
+	}
+}
+
+
+
+// Choisit le backend
+
+Compute::Compute(Backend backend, std::size_t n_thread) {
+	this->backend = backend;
+	this->n_thread = std::max<std::size_t>(n_thread, 1);
+
+	if (!is_available(backend)) {
+		std::cerr << (backend == openmp ? "OpenMP indisponible (compiler avec GALAXY_OPENMP)" : "Algorithmes parallèles de la STL indisponibles (TBB introuvable à la compilation)")
+				  << " : threads du projet" << std::endl;
+		this->backend = std_threads;
+	}
+
+#ifdef GALAXY_OPENMP
+	// Les variables OMP_* gardent la main : n_thread et l'ordonnancement dynamique ne sont que des valeurs par défaut
+	if (this->backend == openmp) {
+		if (!std::getenv("OMP_NUM_THREADS"))
+			omp_set_num_threads(static_cast<int>(this->n_thread));
+
+		if (!std::getenv("OMP_SCHEDULE"))
+			omp_set_schedule(omp_sched_dynamic, 1);
+
+		this->n_thread = static_cast<std::size_t>(omp_get_max_threads());
+	}
+#endif
+
+	if (this->backend == std_threads && this->n_thread > 1)
+		pool = std::make_shared<Thread_pool>(this->n_thread - 1);
+}
+
+
+
+// Indique si un backend a été compilé
+
+bool Compute::is_available(Backend backend) {
+	switch (backend) {
+		case parallel_stl:
+#ifdef GALAXY_PARALLEL_STL
+			return true;
+#else
+			return false;
+#endif
+
+		case openmp:
+#ifdef GALAXY_OPENMP
+			return true;
+#else
+			return false;
+#endif
+
+		case std_threads:
+			break;
+	}
+
+	return true;
+}
+
+
+
+// Nombre d'intervalles : un par thread du projet, plusieurs par thread pour les backends à tâches (ils s'équilibrent)
+
+std::size_t Compute::chunks(std::size_t count) const {
+	const std::size_t limit = backend == std_threads ? n_thread : 8 * n_thread;
+
+	return std::clamp<std::size_t>((count + grain - 1) / grain, 1, limit);
+}
+
+
+
+// Indique si un travail est découpé en tâches imbriquées
+
+bool Compute::is_nested(std::size_t count) const {
+	return backend != std_threads && n_thread > 1 && count >= grain;
+}
+
+
+
+// Lance des tâches indépendantes et attend leur fin (le thread appelant y participe)
+
+void Compute::tasks(std::size_t count, const std::function<void(std::size_t)> &task) const {
+	if (count <= 1) {
+		if (count == 1)
+			task(0);
+		return;
+	}
+
+#ifdef GALAXY_PARALLEL_STL
+	if (backend == parallel_stl) {
+		std::vector<std::size_t> indices(count);
+		std::iota(indices.begin(), indices.end(), 0);
+		std::for_each(std::execution::par, indices.begin(), indices.end(), task);
+		return;
+	}
+#endif
+
+#ifdef GALAXY_OPENMP
+	if (backend == openmp) {
+		// Depuis une tâche : tâches OpenMP, reprises par les threads de l'équipe qui n'ont plus de travail
+		if (omp_in_parallel()) {
+			for (std::size_t i = 0; i < count; ++i) {
+				#pragma omp task firstprivate(i) shared(task)
+				task(i);
+			}
+
+			#pragma omp taskwait
+			return;
+		}
+
+		#pragma omp parallel for schedule(runtime)
+		for (std::size_t i = 0; i < count; ++i)
+			task(i);
+
+		return;
+	}
+#endif
+
+	// Pool absent (un seul thread) ou lot imbriqué : à la suite, dans le thread appelant
+	if (!pool || !pool->run(count, task))
+		for (std::size_t i = 0; i < count; ++i)
+			task(i);
+}
+
+
+
+// Découpe [0, count) en intervalles contigus traités en parallèle
+
+void Compute::for_ranges(std::size_t count, const std::function<void(std::size_t, std::size_t, std::size_t)> &work) const {
+	const std::size_t n = chunks(count);
+
+	tasks(n, [&work, count, n](std::size_t chunk) {
+		work(chunk, count * chunk / n, count * (chunk + 1) / n);
+	});
+}
+
+
+
+// Partition parallèle
+
+Star::container::iterator Compute::partition(const Star::range &stars, const std::function<bool(const Star &)> &predicate) const {
+	const auto count = static_cast<std::size_t>(std::distance(stars.begin, stars.end));
+	const std::size_t n = chunks(count);
+
+	if (n <= 1)
+		return std::partition(stars.begin, stars.end, predicate);
+
+#ifdef GALAXY_PARALLEL_STL
+	if (backend == parallel_stl)
+		return std::partition(std::execution::par, stars.begin, stars.end, predicate);
+#endif
+
+	// Chaque intervalle est partitionné sur place
+	std::vector<std::size_t> firsts(n), middles(n), lasts(n);
+
+	for_ranges(count, [&stars, &predicate, &firsts, &middles, &lasts](std::size_t chunk, std::size_t begin, std::size_t end) {
+		firsts[chunk] = begin;
+		lasts[chunk] = end;
+		middles[chunk] = static_cast<std::size_t>(std::partition(stars.begin + begin, stars.begin + end, predicate) - stars.begin);
+	});
+
+	std::size_t split = 0;
+	for (std::size_t c = 0; c < n; ++c)
+		split += middles[c] - firsts[c];
+
+	// Étoiles du mauvais côté de la frontière globale : autant de chaque côté, échangées deux à deux
+	std::vector<std::pair<std::size_t, std::size_t>> wrong_before, wrong_after;
+	std::size_t misplaced = 0;
+
+	for (std::size_t c = 0; c < n; ++c) {
+		if (middles[c] < std::min(lasts[c], split)) {
+			wrong_before.emplace_back(middles[c], std::min(lasts[c], split));
+			misplaced += wrong_before.back().second - wrong_before.back().first;
+		}
+
+		if (std::max(firsts[c], split) < middles[c])
+			wrong_after.emplace_back(std::max(firsts[c], split), middles[c]);
+	}
+
+	// Position de la k-ième étoile d'une liste d'intervalles
+	const auto locate = [](const std::vector<std::pair<std::size_t, std::size_t>> &intervals, std::size_t k) {
+		std::size_t interval = 0;
+
+		while (k >= intervals[interval].second - intervals[interval].first) {
+			k -= intervals[interval].second - intervals[interval].first;
+			++interval;
+		}
+
+		return std::pair{ interval, intervals[interval].first + k };
+	};
+
+	for_ranges(misplaced, [&stars, &wrong_before, &wrong_after, &locate](std::size_t, std::size_t begin, std::size_t end) {
+		if (begin == end)
+			return;
+
+		auto [before, i] = locate(wrong_before, begin);
+		auto [after, j] = locate(wrong_after, begin);
+
+		for (std::size_t k = begin; k < end; ++k) {
+			if (i == wrong_before[before].second)
+				i = wrong_before[++before].first;
+
+			if (j == wrong_after[after].second)
+				j = wrong_after[++after].first;
+
+			std::iter_swap(stars.begin + i++, stars.begin + j++);
+		}
+	});
+
+	return stars.begin + split;
+}
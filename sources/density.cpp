@@ -0,0 +1,55 @@
+#include "density.h"
+#include "utils.h"
+#include "query.h"
+
+// Noyau spline cubique (support h)
+
+double sph_kernel(const double &distance, const double &h) {
+	const double q = distance / h;
+	const double norm = 8. / (PI * h * h * h);
+
+	if (q <= 0.5)
+		return norm * (1. - 6. * q * q + 6. * q * q * q);
+
+	if (q < 1.)
+		return norm * 2. * (1. - q) * (1. - q) * (1. - q);
+
+	return 0.;
+}
+
+
+
+// Estime la densité de toutes les étoiles, réparties par intervalles contigus (une recherche de voisins par étoile :
+// éléments lourds, découpés même sous le grain)
+
+void Density_estimator::estimate(const Block &root, const Star::range &stars, std::size_t nb_ids, const Compute &compute) {
+	const auto count = static_cast<std::size_t>(std::distance(stars.begin, stars.end));
+	const std::size_t k = std::max<std::size_t>(neighbours, 2);
+	densities.resize(nb_ids, 0.);
+
+	if (root.nb_stars == 0)
+		return;
+
+	Compute searches = compute;
+	searches.grain = 1;
+
+	searches.for_ranges(count, [this, &root, &stars, k](std::size_t, std::size_t begin, std::size_t end) {
+		std::vector<Neighbour> found;
+		found.reserve(k);
+
+		// Les étoiles sont dans l'ordre de l'octree : deux étoiles successives parcourent presque les mêmes blocs
+		for (std::size_t i = begin; i < end; ++i) {
+			const Star &star = stars.begin[i];
+			nearest_stars(root, star.position, k, found);
+
+			const double h = std::sqrt(found.back().distance2) / LIGHT_YEAR;
+			double density = 0.;
+
+			if (h > 0.)
+				for (const auto &neighbour : found)
+					density += neighbour.star->mass / SOLAR_MASS * sph_kernel(std::sqrt(neighbour.distance2) / LIGHT_YEAR, h);
+
+			densities[star.index] = density;
+		}
+	});
+}
@@ -0,0 +1,137 @@
+#include "diagnostics.h"
+#include "utils.h"
+#include "softening.h"
+
+// Potentiel en un point par le parcours de l'arbre (l'étoile située au point lui-même est ignorée)
+
+double potential_calculation(const double &precision, const glm::dvec3 &position, const Block &block) {
+	const auto offset = position - block.mass_center;
+	const double distance2 = glm::dot(offset, offset);
+
+	if (block.nb_stars == 1 && distance2 == 0.)
+		return 0.;
+
+	if (block.nb_stars == 1 || block.size * block.size < precision * precision * distance2)
+		return G * block.mass * Softening::potential(distance2, SOFTENING_LENGTH);
+
+	double potential = 0.;
+	for (const auto &child : std::get<1>(block.contains))
+		if (child.nb_stars > 0)
+			potential += potential_calculation(precision, position, child);
+
+	return potential;
+}
+
+
+
+// Effectue les mesures (énergie potentielle et erreur de la force réparties par le backend de calcul)
+
+void Diagnostics::measure(const Star::range &stars, const Block &block, const double &precision,
+						  const std::function<glm::dvec3(Star)> &acceleration, const Compute &compute) {
+	const auto count = static_cast<std::size_t>(std::distance(stars.begin, stars.end));
+	kinetic_energy = potential_energy = total_mass = typical_speed = 0.;
+	momentum = angular_momentum = { 0., 0., 0. };
+
+	for (auto it = stars.begin; it != stars.end; ++it) {
+		kinetic_energy += 0.5 * it->mass * glm::dot(it->speed, it->speed);
+		momentum += it->speed * it->mass;
+		angular_momentum += glm::cross(it->position, it->speed) * it->mass;
+		total_mass += it->mass;
+	}
+
+	if (count == 0)
+		return;
+
+	typical_speed = std::sqrt(2. * kinetic_energy / total_mass);
+
+	// Étoiles échantillonnées à intervalle régulier : l'ordre du conteneur suit l'octree, l'échantillon couvre l'espace
+	const std::size_t nb_samples = std::min(samples, count);
+	std::vector<double> errors(nb_samples);
+	direct.load(stars);
+
+	// Un parcours de l'arbre ou une somme directe par élément : éléments lourds, découpés même sous le grain
+	Compute walks = compute;
+	walks.grain = 1;
+
+	potential_energy = walks.reduce(count, 0., [this, &stars, &block, &precision](std::size_t begin, std::size_t end) {
+		double potential = 0.;
+
+		for (auto it = stars.begin + begin; it != stars.begin + end; ++it) {
+			potential += 0.5 * it->mass * potential_calculation(precision, it->position, block);
+
+			if (external) // Champ fixe : pas de facteur 1/2, chaque étoile n'interagit qu'avec lui
+				potential += it->mass * external->potential(it->position);
+		}
+
+		return potential;
+	}, std::plus<>());
+
+	walks.tasks(nb_samples, [this, &stars, &acceleration, &errors, count, nb_samples](std::size_t s) {
+		const auto &star = stars.begin[s * count / nb_samples];
+		double density = 0.;
+		const auto reference = direct.acceleration(star.position, density);
+		errors[s] = glm::length(acceleration(star) - reference) / glm::length(reference);
+	});
+
+	virial_ratio = potential_energy != 0. ? 2. * kinetic_energy / std::abs(potential_energy) : 0.;
+
+	// Sans échantillon (samples nul) : pas de centiles, les erreurs restent à 0
+	std::sort(errors.begin(), errors.end());
+	const std::array<double, 3> percentiles = { 0.5, 0.9, 0.99 };
+	for (std::size_t p = 0; p < percentiles.size(); ++p)
+		force_errors[p] = nb_samples > 0 ? errors[std::min(nb_samples - 1, static_cast<std::size_t>(percentiles[p] * static_cast<double>(nb_samples)))] : 0.;
+
+	if (!has_reference) {
+		has_reference = true;
+		initial_energy = kinetic_energy + potential_energy;
+		initial_momentum = momentum;
+		initial_angular_momentum = angular_momentum;
+	}
+}
+
+
+
+// Écrit une ligne de résultats
+
+void Diagnostics::print(std::ostream &stream, std::size_t step) {
+	const double energy = kinetic_energy + potential_energy;
+	const double energy_drift = initial_energy != 0. ? (energy - initial_energy) / std::abs(initial_energy) : 0.;
+	const double momentum_drift = total_mass * typical_speed > 0. ? glm::length(momentum - initial_momentum) / (total_mass * typical_speed) : 0.;
+	const double angular_norm = glm::length(initial_angular_momentum);
+	const double angular_drift = angular_norm > 0. ? glm::length(angular_momentum - initial_angular_momentum) / angular_norm : 0.;
+
+	const auto flags = stream.flags();
+	const auto precision = stream.precision();
+	stream << std::scientific << std::setprecision(3)
+		   << "[diagnostics] pas " << step
+		   << " | E " << energy << " (dE/E " << energy_drift << ")"
+		   << " K " << kinetic_energy << " W " << potential_energy << " 2K/|W| " << virial_ratio
+		   << " | dP " << momentum_drift << " dL " << angular_drift
+		   << " | erreur force p50 " << force_errors[0] << " p90 " << force_errors[1] << " p99 " << force_errors[2]
+		   << std::endl;
+	stream.flags(flags);
+	stream.precision(precision);
+}
+
+
+
+// Écrit la mémoire occupée par étoile
+
+void print_memory(std::ostream &stream, const Star::container &galaxy, const Block &root, const std::vector<Star::index_type> &slots) {
+	const double count = static_cast<double>(std::max<std::size_t>(galaxy.size(), 1));
+	const double stars = static_cast<double>(galaxy.capacity() * sizeof(Star)) / count;
+	const double tree = static_cast<double>(tree_memory(root)) / count;
+	const double tables = static_cast<double>(slots.capacity() * sizeof(Star::index_type)) / count;
+
+	const auto flags = stream.flags();
+	const auto precision = stream.precision();
+	stream << std::fixed << std::setprecision(1)
+		   << "[mémoire] étoile " << sizeof(Star) << " o, bloc " << sizeof(Block) << " o (" << tree / sizeof(Block) << " blocs par étoile)"
+		   << " | par étoile : étoiles " << stars << " + arbre " << tree << " + identifiants " << tables << " = " << stars + tree + tables << " o"
+#ifdef GALAXY_COMPACT
+		   << " (mode compact)"
+#endif
+		   << std::endl;
+	stream.flags(flags);
+	stream.precision(precision);
+}
@@ -0,0 +1,94 @@
+#include "direct.h"
+#include "utils.h"
+#include "softening.h"
+
+// Copie les sources en structure de tableaux
+
+void Direct::load(const Star::range &sources) {
+	const auto count = static_cast<std::size_t>(std::distance(sources.begin, sources.end));
+	x.resize(count);
+	y.resize(count);
+	z.resize(count);
+	mass.resize(count);
+
+	std::size_t j = 0;
+	for (auto it = sources.begin; it != sources.end; ++it, ++j) {
+		x[j] = it->position.x;
+		y[j] = it->position.y;
+		z[j] = it->position.z;
+		mass[j] = it->mass;
+	}
+}
+
+
+
+// Calcule une tuile de cibles : pour chaque source, la boucle sur les cibles est vectorisable
+
+void Direct::solve_tile(const Star::range &tile) const {
+	std::array<double, tile_size> tx{}, ty{}, tz{}, ax{}, ay{}, az{}, density{};
+	const auto count = static_cast<std::size_t>(std::distance(tile.begin, tile.end));
+
+	for (std::size_t i = 0; i < count; ++i) {
+		tx[i] = tile.begin[i].position.x;
+		ty[i] = tile.begin[i].position.y;
+		tz[i] = tile.begin[i].position.z;
+	}
+
+	for (std::size_t j = 0; j < x.size(); ++j) {
+		const double sx = x[j], sy = y[j], sz = z[j], sm = mass[j];
+
+		for (std::size_t i = 0; i < tile_size; ++i) {
+			const double dx = sx - tx[i], dy = sy - ty[i], dz = sz - tz[i];
+			const double distance2 = dx * dx + dy * dy + dz * dz;
+			const double inv_distance = distance2 > 0. ? 1. / std::sqrt(distance2) : 0.; // Pas d'interaction avec soi-même
+			const double factor = sm * Softening::force(distance2, SOFTENING_LENGTH);
+			ax[i] += dx * factor;
+			ay[i] += dy * factor;
+			az[i] += dz * factor;
+			density[i] += inv_distance;
+		}
+	}
+
+	for (std::size_t i = 0; i < count; ++i) {
+		tile.begin[i].acceleration = glm::dvec3(ax[i], ay[i], az[i]) * G;
+		tile.begin[i].density = density[i] / LIGHT_YEAR;
+	}
+}
+
+
+
+// Calcule l'accélération et la densité des cibles, une tâche par tuile : le backend les distribue dynamiquement
+
+void Direct::solve(const Star::range &targets, const Compute &compute) const {
+	const auto count = static_cast<std::size_t>(std::distance(targets.begin, targets.end));
+	const std::size_t nb_tiles = (count + tile_size - 1) / tile_size;
+
+	compute.tasks(nb_tiles, [this, &targets, count](std::size_t tile) {
+		const auto begin = targets.begin + static_cast<std::ptrdiff_t>(tile * tile_size);
+		const auto end = targets.begin + static_cast<std::ptrdiff_t>(std::min(count, (tile + 1) * tile_size));
+		solve_tile({ begin, end });
+	});
+}
+
+
+
+// Accélération exacte en un point
+
+glm::dvec3 Direct::acceleration(const glm::dvec3 &position, double &density) const {
+	glm::dvec3 result(0.);
+	density = 0.;
+
+	for (std::size_t j = 0; j < x.size(); ++j) {
+		const glm::dvec3 d = { x[j] - position.x, y[j] - position.y, z[j] - position.z };
+		const double distance2 = glm::dot(d, d);
+
+		if (distance2 > 0.) {
+			const double inv_distance = 1. / std::sqrt(distance2);
+			result += d * (mass[j] * Softening::force(distance2, SOFTENING_LENGTH));
+			density += inv_distance;
+		}
+	}
+
+	density /= LIGHT_YEAR;
+	return result * G;
+}
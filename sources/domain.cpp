@@ -0,0 +1,383 @@
+#include "domain.h"
+#include "utils.h"
+#include <cstring>
+
+// Étoile telle qu'elle circule entre les rangs (Star a une table virtuelle : pas de copie brute)
+struct Star_record {
+	glm::dvec3 position;
+	glm::dvec3 speed;
+	glm::dvec3 acceleration;
+	double mass;
+	double density;
+	std::uint64_t index;
+	glm::u8vec3 color;
+	std::uint8_t rung;
+};
+
+// Ajoute une valeur à un message
+
+template<typename T>
+static void append(std::vector<char> &message, const T &value) {
+	const auto offset = message.size();
+	message.resize(offset + sizeof(T));
+	std::memcpy(message.data() + offset, &value, sizeof(T));
+}
+
+
+
+// Lit une valeur d'un message et avance la position de lecture
+
+template<typename T>
+static T take(const std::vector<char> &message, std::size_t &offset) {
+	T value;
+	std::memcpy(&value, message.data() + offset, sizeof(T));
+	offset += sizeof(T);
+	return value;
+}
+
+
+
+// Ajoute une étoile à un message
+
+static void append_star(std::vector<char> &message, const Star &star, const double &density) {
+	append(message, Star_record{ star.position, star.speed, star.acceleration, star.mass, density, star.index, star.color, star.rung });
+}
+
+
+
+// Ajoute toutes les étoiles d'un message à un conteneur
+
+static void take_stars(const std::vector<char> &message, Star::container &stars) {
+	for (std::size_t offset = 0; offset < message.size();) {
+		const auto record = take<Star_record>(message, offset);
+		Star star;
+		star.position = record.position;
+		star.speed = record.speed;
+		star.acceleration = record.acceleration;
+		star.mass = record.mass;
+		star.density = record.density;
+		star.index = record.index;
+		star.color = record.color;
+		star.rung = record.rung;
+		star.is_alive = true;
+		stars.push_back(star);
+	}
+}
+
+
+
+// Écarte les bits d'un entier de 21 bits (un bit utile tous les trois)
+
+static std::uint64_t spread_bits(std::uint64_t value) {
+	value &= 0x1fffff;
+	value = (value | value << 32) & 0x1f00000000ffff;
+	value = (value | value << 16) & 0x1f0000ff0000ff;
+	value = (value | value << 8) & 0x100f00f00f00f00f;
+	value = (value | value << 4) & 0x10c30c30c30c30c3;
+	value = (value | value << 2) & 0x1249249249249249;
+	return value;
+}
+
+
+
+// Clé de Morton d'une position
+
+std::uint64_t morton_key(const glm::dvec3 &position, const Bounding_box &box) {
+	const auto extent = box.max - box.min;
+	const double size = std::max({ extent.x, extent.y, extent.z });
+
+	if (box.is_empty() || size <= 0.)
+		return 0;
+
+	constexpr double resolution = double((1 << 21) - 1);
+	std::uint64_t key = 0;
+
+	for (int axis = 0; axis < 3; ++axis) {
+		const double coordinate = std::clamp((position[axis] - box.min[axis]) / size, 0., 1.) * resolution;
+		key |= spread_bits(static_cast<std::uint64_t>(coordinate)) << axis;
+	}
+
+	return key;
+}
+
+
+
+// Distance au carré entre un point et une boîte (nulle à l'intérieur)
+
+static double box_distance2(const Bounding_box &box, const glm::dvec3 &position) {
+	double distance2 = 0.;
+
+	for (int axis = 0; axis < 3; ++axis) {
+		const double outside = std::max({ box.min[axis] - position[axis], position[axis] - box.max[axis], 0. });
+		distance2 += outside * outside;
+	}
+
+	return distance2;
+}
+
+
+
+// Parcours de l'arbre local pour un autre rang : un bloc assez loin de toute sa boîte part en pseudo-étoile
+// (la densité d'un fantôme est le nombre d'étoiles qu'il représente)
+
+static void essential_blocks(const Block &block, const Bounding_box &box, const double &precision, std::vector<char> &message) {
+	if (block.nb_stars == 1) {
+		append_star(message, *std::get<0>(block.contains), 1.);
+		return;
+	}
+
+	// Accepté pour le point de la boîte le plus proche, donc pour tous (même critère que force_and_density_calculation)
+	const double distance2 = box_distance2(box, block.mass_center);
+	if (distance2 > 0. && block.size * block.size < precision * precision * distance2) {
+		Star pseudo_star;
+		pseudo_star.position = block.mass_center;
+		pseudo_star.mass = block.mass;
+		append_star(message, pseudo_star, static_cast<double>(block.nb_stars));
+		return;
+	}
+
+	for (const auto &child : std::get<1>(block.contains))
+		if (child.nb_stars > 0)
+			essential_blocks(child, box, precision, message);
+}
+
+
+
+// Arbre des fantômes : nombre d'étoiles représentées par chaque bloc, pseudo-étoiles comprises
+
+static Star::index_type count_ghost_stars(Block &block) {
+	if (!block.as_children) {
+		if (block.nb_stars == 1)
+			block.nb_stars = static_cast<Star::index_type>(std::get<0>(block.contains)->density);
+
+		return block.nb_stars;
+	}
+
+	Star::index_type count = 0;
+	for (auto &child : std::get<1>(block.contains))
+		count += count_ghost_stars(child);
+
+	block.nb_stars = count;
+	return count;
+}
+
+
+
+// Construit la décomposition d'un rang
+
+Domain::Domain(Transport &transport) {
+	this->transport = &transport;
+}
+
+
+
+// Indique si plusieurs rangs se partagent la simulation
+
+bool Domain::is_distributed() const {
+	return transport->size() > 1;
+}
+
+
+
+// Première répartition : chaque rang garde une tranche contiguë puis les étoiles rejoignent leur rang
+
+void Domain::distribute(Star::container &galaxy, Star::range &alive_galaxy, std::vector<Star::index_type> &slots) {
+	const std::size_t count = galaxy.size();
+	const std::size_t begin = count * transport->rank() / transport->size();
+	const std::size_t end = count * (transport->rank() + 1) / transport->size();
+
+	galaxy.erase(galaxy.begin() + end, galaxy.end());
+	galaxy.erase(galaxy.begin(), galaxy.begin() + begin);
+	alive_galaxy = { galaxy.begin(), galaxy.end() };
+
+	balance(alive_galaxy);
+	migrate(galaxy, alive_galaxy, slots);
+}
+
+
+
+// Recalcule la boîte, le centre de gravité global et les séparateurs
+
+void Domain::balance(const Star::range &stars) {
+	const std::size_t nb_ranks = transport->size();
+
+	// Boîte et centre de gravité globaux : chaque rang envoie les siens à tous
+	{
+		Bounding_box local_box = bounding_box(stars, compute);
+		const auto count = static_cast<std::size_t>(std::distance(stars.begin, stars.end));
+		auto [mass, moment] = compute.reduce(count, std::pair{ 0., glm::dvec3(0.) }, [&stars](std::size_t begin, std::size_t end) {
+			std::pair partial{ 0., glm::dvec3(0.) };
+
+			for (auto it = stars.begin + begin; it != stars.begin + end; ++it) {
+				partial.first += it->mass;
+				partial.second += it->position * it->mass;
+			}
+
+			return partial;
+		}, [](const std::pair<double, glm::dvec3> &sum, const std::pair<double, glm::dvec3> &partial) {
+			return std::pair{ sum.first + partial.first, sum.second + partial.second };
+		});
+
+		std::vector<char> message;
+		append(message, local_box);
+		append(message, mass);
+		append(message, moment);
+
+		box = Bounding_box();
+		mass = 0.;
+		moment = glm::dvec3(0.);
+
+		for (const auto &received : transport->exchange(std::vector<std::vector<char>>(nb_ranks, message))) {
+			std::size_t offset = 0;
+			box.merge(take<Bounding_box>(received, offset));
+			mass += take<double>(received, offset);
+			moment += take<glm::dvec3>(received, offset);
+		}
+
+		mass_center = mass > 0. ? moment / mass : glm::dvec3(0.);
+	}
+
+	// Échantillon régulier des clés triées de chaque rang, chaque clé pesant les étoiles qu'elle représente
+	std::vector<std::uint64_t> keys;
+	keys.reserve(static_cast<std::size_t>(std::distance(stars.begin, stars.end)));
+	for (auto it = stars.begin; it != stars.end; ++it)
+		keys.push_back(morton_key(it->position, box));
+
+	std::sort(keys.begin(), keys.end());
+
+	std::vector<char> message;
+	const std::size_t nb_samples = std::min(samples, keys.size());
+
+	for (std::size_t s = 0; s < nb_samples; ++s) {
+		append(message, keys[(2 * s + 1) * keys.size() / (2 * nb_samples)]);
+		append(message, double(keys.size()) / double(nb_samples));
+	}
+
+	std::vector<std::pair<std::uint64_t, double>> weighted;
+	double total = 0.;
+
+	for (const auto &received : transport->exchange(std::vector<std::vector<char>>(nb_ranks, message)))
+		for (std::size_t offset = 0; offset < received.size();) {
+			const auto key = take<std::uint64_t>(received, offset);
+			const auto weight = take<double>(received, offset);
+			weighted.emplace_back(key, weight);
+			total += weight;
+		}
+
+	// Mêmes données sur tous les rangs : tous trouvent les mêmes séparateurs
+	std::sort(weighted.begin(), weighted.end());
+	splits.assign(nb_ranks - 1, std::numeric_limits<std::uint64_t>::max());
+
+	double cumulated = 0.;
+	std::size_t next = 0;
+
+	for (const auto &[key, weight] : weighted) {
+		cumulated += weight;
+
+		while (next < splits.size() && cumulated >= total * double(next + 1) / double(nb_ranks))
+			splits[next++] = key;
+	}
+}
+
+
+
+// Rang propriétaire d'une étoile
+
+std::size_t Domain::owner(const Star &star) const {
+	return static_cast<std::size_t>(std::upper_bound(splits.begin(), splits.end(), morton_key(star.position, box)) - splits.begin());
+}
+
+
+
+// Envoie les étoiles à leur rang
+
+void Domain::migrate(Star::container &galaxy, Star::range &alive_galaxy, std::vector<Star::index_type> &slots) {
+	const std::size_t rank = transport->rank();
+	std::vector<std::vector<char>> messages(transport->size());
+	std::vector<std::size_t> leaving;
+
+	for (auto it = alive_galaxy.begin; it != alive_galaxy.end; ++it) {
+		const std::size_t destination = owner(*it);
+
+		if (destination != rank) {
+			append_star(messages[destination], *it, it->density);
+			leaving.push_back(static_cast<std::size_t>(std::distance(galaxy.begin(), it)));
+		}
+	}
+
+	// Les étoiles parties rejoignent les mortes à la fin du conteneur, puis toutes sont supprimées
+	remove_escaped(galaxy, alive_galaxy, leaving, slots);
+	galaxy.erase(alive_galaxy.end, galaxy.end());
+
+	const auto received = transport->exchange(messages);
+	for (std::size_t r = 0; r < received.size(); ++r)
+		if (r != rank)
+			take_stars(received[r], galaxy);
+
+	alive_galaxy = { galaxy.begin(), galaxy.end() };
+
+	for (std::size_t i = 0; i < galaxy.size(); ++i)
+		slots[galaxy[i].index] = i;
+}
+
+
+
+// Échange les arbres localement essentiels
+
+void Domain::exchange_essential(const Block &root, const Star::range &stars, const double &precision) {
+	const std::size_t rank = transport->rank();
+	const std::size_t nb_ranks = transport->size();
+
+	// Boîtes exactes des étoiles de chaque rang (elles ont dérivé depuis la répartition)
+	std::vector<char> local_box;
+	append(local_box, bounding_box(stars, compute));
+
+	domains.clear();
+	for (const auto &received : transport->exchange(std::vector<std::vector<char>>(nb_ranks, local_box))) {
+		std::size_t offset = 0;
+		domains.push_back(take<Bounding_box>(received, offset));
+	}
+
+	std::vector<std::vector<char>> messages(nb_ranks);
+	for (std::size_t r = 0; r < nb_ranks; ++r)
+		if (r != rank && !domains[r].is_empty() && root.nb_stars > 0)
+			essential_blocks(root, domains[r], precision, messages[r]);
+
+	const auto received = transport->exchange(messages);
+
+	ghosts.clear();
+	for (std::size_t r = 0; r < received.size(); ++r)
+		if (r != rank)
+			take_stars(received[r], ghosts);
+
+	Star::range ghost_range = { ghosts.begin(), ghosts.end() };
+	create_blocks(bounding_box(ghost_range, compute), ghost_root, ghost_range, compute);
+	count_ghost_stars(ghost_root); // Densité : une pseudo-étoile pèse autant que le bloc qu'elle remplace
+}
+
+
+
+// Rassemble toutes les étoiles sur le rang 0
+
+Star::container Domain::gather(const Star::range &stars, const std::vector<double> *densities) {
+	std::vector<std::vector<char>> messages(transport->size());
+
+	for (auto it = stars.begin; it != stars.end; ++it)
+		append_star(messages[0], *it, densities ? (*densities)[it->index] : it->density);
+
+	Star::container all;
+	for (const auto &received : transport->exchange(messages))
+		take_stars(received, all);
+
+	return all;
+}
+
+
+
+// Vrai si un rang au moins a flag vrai
+
+bool Domain::any(bool flag) {
+	const auto received = transport->exchange(std::vector<std::vector<char>>(transport->size(), std::vector<char>(1, flag)));
+
+	return std::any_of(received.begin(), received.end(), [](const std::vector<char> &message) { return message[0] != 0; });
+}
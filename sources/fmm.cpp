@@ -0,0 +1,417 @@
+#include "fmm.h"
+#include "utils.h"
+#include "softening.h"
+
+// Construit le solveur avec un ordre donné
+
+Fmm::Fmm(int order, std::size_t leaf_size) {
+	set_order(order);
+	this->leaf_size = leaf_size;
+}
+
+
+
+// Précalcule les multi-indices et les termes des translations
+
+void Fmm::set_order(int order) {
+	this->order = std::clamp(order, 1, 31);
+	multi_indices.clear();
+	lookup.assign(static_cast<std::size_t>((this->order + 1) * (this->order + 1) * (this->order + 1)), -1);
+
+	for (int degree = 0; degree <= this->order; ++degree)
+		for (int i = degree; i >= 0; --i)
+			for (int j = degree - i; j >= 0; --j) {
+				lookup[((i * (this->order + 1)) + j) * (this->order + 1) + (degree - i - j)] = static_cast<int>(multi_indices.size());
+				multi_indices.push_back({ i, j, degree - i - j });
+			}
+
+	nb_coefficients = multi_indices.size();
+
+	std::vector<double> factorials(static_cast<std::size_t>(this->order + 1), 1.);
+	for (std::size_t i = 1; i < factorials.size(); ++i)
+		factorials[i] = factorials[i - 1] * static_cast<double>(i);
+
+	inverse_factorials.resize(nb_coefficients);
+	for (std::size_t t = 0; t < nb_coefficients; ++t) {
+		const auto &n = multi_indices[t];
+		inverse_factorials[t] = 1. / (factorials[n[0]] * factorials[n[1]] * factorials[n[2]]);
+	}
+
+	lower_indices.resize(nb_coefficients);
+	for (std::size_t t = 0; t < nb_coefficients; ++t) {
+		const auto &n = multi_indices[t];
+
+		for (int axis = 0; axis < 3; ++axis) {
+			lower_indices[t][axis] = index(n[0] - (axis == 0), n[1] - (axis == 1), n[2] - (axis == 2));
+			lower_indices[t][axis + 3] = index(n[0] - 2 * (axis == 0), n[1] - 2 * (axis == 1), n[2] - 2 * (axis == 2));
+		}
+	}
+
+	nested_terms.clear();
+	m2l_terms.clear();
+	for (auto &terms : gradient_terms)
+		terms.clear();
+
+	for (std::size_t small = 0; small < nb_coefficients; ++small) {
+		const auto &a = multi_indices[small];
+
+		for (std::size_t big = 0; big < nb_coefficients; ++big) {
+			const auto &b = multi_indices[big];
+
+			// Translations emboîtées (M2M et L2L) : small <= big composante par composante
+			const int diff = index(b[0] - a[0], b[1] - a[1], b[2] - a[2]);
+			if (diff >= 0)
+				nested_terms.push_back({ big, small, static_cast<std::size_t>(diff), 1. });
+
+			// M2L : L_a += (-1)^|b| M_b D_(a+b), pour |a| + |b| <= order
+			const int sum = index(a[0] + b[0], a[1] + b[1], a[2] + b[2]);
+			if (sum >= 0)
+				m2l_terms.push_back({ small, big, static_cast<std::size_t>(sum), (b[0] + b[1] + b[2]) % 2 == 0 ? 1. : -1. });
+		}
+
+		// Gradient d'un développement local : dérivée selon l'axe = sum_a L_(a+e_axe) x^a / a!
+		for (int axis = 0; axis < 3; ++axis) {
+			const int shifted = index(a[0] + (axis == 0), a[1] + (axis == 1), a[2] + (axis == 2));
+			if (shifted >= 0)
+				gradient_terms[axis].push_back({ 0, static_cast<std::size_t>(shifted), small, 1. });
+		}
+	}
+}
+
+
+
+// Donne l'ordre des développements
+
+int Fmm::get_order() const {
+	return order;
+}
+
+
+
+// Donne l'indice d'un multi-indice, -1 s'il dépasse l'ordre
+
+int Fmm::index(int i, int j, int k) const {
+	if (i < 0 || j < 0 || k < 0 || i + j + k > order)
+		return -1;
+
+	return lookup[static_cast<std::size_t>(((i * (order + 1)) + j) * (order + 1) + k)];
+}
+
+
+
+// Donne la première étoile d'un bloc non vide (les étoiles d'un bloc sont contiguës)
+
+static Star::container::iterator first_star(const Block &block) {
+	if (block.nb_stars == 1)
+		return std::get<0>(block.contains);
+
+	for (const auto &child : std::get<1>(block.contains))
+		if (child.nb_stars > 0)
+			return first_star(child);
+
+	return {};
+}
+
+
+
+// Aplatit un bloc non vide et ses descendants (ordre préfixe), donne l'indice de la cellule
+
+std::size_t Fmm::flatten(const Block &block) {
+	const std::size_t id = cells.size();
+	cells.emplace_back();
+
+	Cell cell;
+	cell.center = block.mass_center;
+	cell.nb_stars = block.nb_stars;
+	cell.stars.begin = first_star(block);
+	cell.stars.end = cell.stars.begin + static_cast<std::ptrdiff_t>(block.nb_stars);
+	cell.is_leaf = block.nb_stars <= leaf_size;
+
+	if (cell.is_leaf) {
+		for (auto it = cell.stars.begin; it != cell.stars.end; ++it)
+			cell.radius = std::max(cell.radius, glm::distance(cell.center, it->position));
+	} else {
+		for (const auto &child : std::get<1>(block.contains)) {
+			if (child.nb_stars > 0) {
+				const auto child_id = flatten(child);
+				cell.radius = std::max(cell.radius, glm::distance(cell.center, cells[child_id].center) + cells[child_id].radius);
+			}
+		}
+	}
+
+	cell.end = cells.size();
+	cells[id] = cell; // Après les appels récursifs : emplace_back a pu déplacer le tableau
+	return id;
+}
+
+
+
+// Dérivées de 1 / |r| jusqu'à l'ordre des développements (récurrence sur le degré)
+
+void Fmm::derivatives(const glm::dvec3 &r, std::vector<double> &result) const {
+	const double r2 = glm::dot(r, r);
+	const double inv_r2 = 1. / r2;
+
+	result[0] = std::sqrt(inv_r2);
+
+	for (std::size_t t = 1; t < nb_coefficients; ++t) {
+		const auto &n = multi_indices[t];
+		const int degree = n[0] + n[1] + n[2];
+		double first = 0., second = 0.;
+
+		const auto &lower = lower_indices[t];
+
+		for (int axis = 0; axis < 3; ++axis) {
+			if (lower[axis] >= 0)
+				first += n[axis] * r[axis] * result[static_cast<std::size_t>(lower[axis])];
+
+			if (lower[axis + 3] >= 0)
+				second += n[axis] * (n[axis] - 1) * result[static_cast<std::size_t>(lower[axis + 3])];
+		}
+
+		result[t] = (-(2 * degree - 1) * first - (degree - 1) * second) * inv_r2 / degree;
+	}
+}
+
+
+
+// Puissances d^n / n! pour tous les multi-indices
+
+void Fmm::scaled_powers(const glm::dvec3 &d, std::vector<double> &result) const {
+	std::array<std::array<double, 3>, 32> powers; // Puissances successives de chaque composante (ordre < 32)
+	powers[0] = { 1., 1., 1. };
+
+	for (int i = 1; i <= order; ++i)
+		powers[i] = { powers[i - 1][0] * d.x, powers[i - 1][1] * d.y, powers[i - 1][2] * d.z };
+
+	for (std::size_t t = 0; t < nb_coefficients; ++t) {
+		const auto &n = multi_indices[t];
+		result[t] = powers[n[0]][0] * powers[n[1]][1] * powers[n[2]][2] * inverse_factorials[t];
+	}
+}
+
+
+
+// Passe montante : développement multipolaire d'une cellule, depuis ses étoiles (P2M) ou ses enfants (M2M)
+
+void Fmm::upward(std::size_t cell, std::vector<double> &powers) {
+	double *multipole = &multipoles[cell * nb_coefficients];
+	std::fill(multipole, multipole + nb_coefficients, 0.);
+
+	if (cells[cell].is_leaf) {
+		for (auto it = cells[cell].stars.begin; it != cells[cell].stars.end; ++it) {
+			scaled_powers(it->position - cells[cell].center, powers);
+
+			for (std::size_t t = 0; t < nb_coefficients; ++t)
+				multipole[t] += it->mass * powers[t];
+		}
+		return;
+	}
+
+	for (std::size_t child = cell + 1; child < cells[cell].end; child = cells[child].end) {
+		const double *source = &multipoles[child * nb_coefficients];
+		scaled_powers(cells[child].center - cells[cell].center, powers);
+
+		for (const auto &term : nested_terms)
+			multipole[term.target] += source[term.source] * powers[term.power];
+	}
+}
+
+
+
+// Parcours double de l'arbre : seules les cellules de la cible (et ses descendantes) sont modifiées
+
+void Fmm::interact(std::size_t target, std::size_t source, const double &precision, std::vector<double> &buffer) {
+	const Cell &a = cells[target];
+	const Cell &b = cells[source];
+
+	if (target == source) {
+		if (a.is_leaf) {
+			particle_to_particle(target, source);
+			return;
+		}
+
+		for (std::size_t i = target + 1; i < a.end; i = cells[i].end)
+			for (std::size_t j = target + 1; j < a.end; j = cells[j].end)
+				interact(i, j, precision, buffer);
+		return;
+	}
+
+	if (source < target && target < b.end) { // La source contient la cible : jamais approximée
+		for (std::size_t j = source + 1; j < b.end; j = cells[j].end)
+			interact(target, j, precision, buffer);
+		return;
+	}
+
+	if (target < source && source < a.end) { // La cible contient la source
+		for (std::size_t i = target + 1; i < a.end; i = cells[i].end)
+			interact(i, source, precision, buffer);
+		return;
+	}
+
+	const auto r = a.center - b.center;
+	const double distance = glm::length(r);
+
+	if (a.radius + b.radius < precision * distance)
+		multipole_to_local(target, source, r, buffer);
+
+	else if (a.is_leaf && b.is_leaf)
+		particle_to_particle(target, source);
+
+	else if (b.is_leaf || (!a.is_leaf && a.radius >= b.radius)) {
+		for (std::size_t i = target + 1; i < a.end; i = cells[i].end)
+			interact(i, source, precision, buffer);
+	} else {
+		for (std::size_t j = source + 1; j < b.end; j = cells[j].end)
+			interact(target, j, precision, buffer);
+	}
+}
+
+
+
+// Interactions directes entre les étoiles de deux feuilles (seules les étoiles cibles sont modifiées)
+
+void Fmm::particle_to_particle(std::size_t target, std::size_t source) {
+	const auto &sources = cells[source].stars;
+
+	for (auto star = cells[target].stars.begin; star != cells[target].stars.end; ++star) {
+		glm::dvec3 force(0);
+		double density = 0.;
+
+		for (auto other = sources.begin; other != sources.end; ++other) {
+			const auto star_to_mass = star->position - other->position;
+			const double distance2 = glm::dot(star_to_mass, star_to_mass);
+
+			if (distance2 != 0.) {
+				force += star_to_mass * (-(G * other->mass) * Softening::force(distance2, SOFTENING_LENGTH));
+				density += 1. / (std::sqrt(distance2) * LIGHT_YEAR);
+			}
+		}
+
+		star->acceleration += force;
+		star->density += density;
+	}
+}
+
+
+
+// Translation multipôle -> local entre deux cellules bien séparées (r = centre cible - centre source)
+
+void Fmm::multipole_to_local(std::size_t target, std::size_t source, const glm::dvec3 &r, std::vector<double> &buffer) {
+	double *local = &locals[target * nb_coefficients];
+	const double *multipole = &multipoles[source * nb_coefficients];
+
+	derivatives(r, buffer);
+	densities[target] += static_cast<double>(cells[source].nb_stars) / (glm::length(r) / LIGHT_YEAR);
+
+	for (const auto &term : m2l_terms)
+		local[term.target] += term.sign * multipole[term.source] * buffer[term.power];
+}
+
+
+
+// Passe descendante : transmet le développement local et la densité aux enfants (L2L) ou aux étoiles (L2P)
+
+void Fmm::downward(std::size_t cell, std::vector<double> &powers) {
+	const double *local = &locals[cell * nb_coefficients];
+
+	if (cells[cell].is_leaf) {
+		for (auto it = cells[cell].stars.begin; it != cells[cell].stars.end; ++it) {
+			glm::dvec3 gradient(0);
+			scaled_powers(it->position - cells[cell].center, powers);
+
+			for (int axis = 0; axis < 3; ++axis)
+				for (const auto &term : gradient_terms[axis])
+					gradient[axis] += local[term.source] * powers[term.power];
+
+			it->acceleration += gradient * G;
+			it->density += densities[cell];
+		}
+		return;
+	}
+
+	for (std::size_t child = cell + 1; child < cells[cell].end; child = cells[child].end) {
+		double *child_local = &locals[child * nb_coefficients];
+
+		densities[child] += densities[cell];
+		scaled_powers(cells[child].center - cells[cell].center, powers);
+
+		for (const auto &term : nested_terms)
+			child_local[term.source] += local[term.target] * powers[term.power];
+	}
+}
+
+
+
+// Calcule l'accélération et la densité de toutes les étoiles
+
+void Fmm::solve(const Block &root, const double &precision, const Compute &compute) {
+	if (nb_coefficients == 0)
+		set_order(3);
+
+	cells.clear();
+
+	if (root.nb_stars == 0)
+		return;
+
+	flatten(root);
+
+	multipoles.assign(cells.size() * nb_coefficients, 0.);
+	locals.assign(cells.size() * nb_coefficients, 0.);
+	densities.assign(cells.size(), 0.);
+
+	// Découpage en sous-arbres indépendants : on ouvre la plus grosse cellule tant qu'il y a trop peu de tâches
+	std::vector<std::size_t> tasks{ 0 };
+	std::vector<std::size_t> upper;
+
+	while (tasks.size() < 8 * compute.n_thread) {
+		auto biggest = tasks.end();
+
+		for (auto it = tasks.begin(); it != tasks.end(); ++it)
+			if (!cells[*it].is_leaf && (biggest == tasks.end() || cells[*it].nb_stars > cells[*biggest].nb_stars))
+				biggest = it;
+
+		if (biggest == tasks.end())
+			break;
+
+		const auto opened = *biggest;
+		tasks.erase(biggest);
+		upper.push_back(opened);
+
+		for (std::size_t child = opened + 1; child < cells[opened].end; child = cells[child].end)
+			tasks.push_back(child);
+	}
+
+	const auto run = [this, &tasks, &compute](const std::function<void(std::size_t, std::vector<double> &)> &work) {
+		compute.tasks(tasks.size(), [this, &tasks, &work](std::size_t task) {
+			std::vector<double> buffer(nb_coefficients);
+			work(tasks[task], buffer);
+		});
+	};
+
+	// Passe montante : chaque sous-arbre en parallèle (les enfants suivent leur parent en ordre préfixe), puis le haut
+	run([this](std::size_t task, std::vector<double> &powers) {
+		for (std::size_t cell = cells[task].end; cell-- > task;)
+			upward(cell, powers);
+	});
+
+	std::sort(upper.begin(), upper.end(), std::greater<>());
+	{
+		std::vector<double> powers(nb_coefficients);
+		for (const auto cell : upper)
+			upward(cell, powers);
+	}
+
+	// Interactions puis passe descendante, chaque tâche n'écrit que dans son propre sous-arbre
+	run([this, &precision](std::size_t task, std::vector<double> &buffer) {
+		for (auto it = cells[task].stars.begin; it != cells[task].stars.end; ++it) {
+			it->acceleration = { 0., 0., 0. };
+			it->density = 0.;
+		}
+
+		interact(task, 0, precision, buffer);
+
+		for (std::size_t cell = task; cell < cells[task].end; ++cell)
+			downward(cell, buffer);
+	});
+}
@@ -0,0 +1,91 @@
+#include "integrator.h"
+
+// Construit un schéma
+
+Integrator::Integrator(Scheme scheme, const double &step, int max_rung, const double &accuracy, const double &length) {
+	this->step = step;
+	this->max_rung = max_rung;
+	this->accuracy = accuracy;
+	this->length = length;
+
+	switch (scheme) {
+		case euler:
+			weights = { 1. };
+			opening = 1.;
+			closing = 0.;
+			break;
+
+		case leapfrog:
+			weights = { 1. };
+			break;
+
+		case forest_ruth: {
+			const double cbrt2 = std::cbrt(2.);
+			const double w1 = 1. / (2. - cbrt2);
+			weights = { w1, 1. - 2. * w1, w1 }; // w0 = -cbrt(2) / (2 - cbrt(2)) : étape en arrière
+			break;
+		}
+	}
+}
+
+
+
+// Nombre d'étapes (évaluations de force) par pas
+
+std::size_t Integrator::stages() const {
+	return weights.size();
+}
+
+
+
+// Nombre de sous-pas par étape
+
+std::size_t Integrator::substeps() const {
+	return std::size_t{ 1 } << max_rung;
+}
+
+
+
+// Donne le niveau le plus fin
+
+int Integrator::get_max_rung() const {
+	return max_rung;
+}
+
+
+
+// Passe à l'étape suivante
+
+void Integrator::begin_stage(std::size_t stage) {
+	previous_duration = duration;
+	duration = weights[stage] * step;
+}
+
+
+
+// Indique si l'étoile commence un pas
+
+bool Integrator::is_active(const Star &star, std::size_t substep) const {
+	return substep % rung_period(star.rung, max_rung) == 0;
+}
+
+
+
+// Poussées de fin et de début de pas (fusionnées : même force)
+
+void Integrator::kick(Star &star, std::size_t substep) const {
+	// Au premier sous-pas, le pas qui se termine appartient à l'étape précédente
+	const double ending = substep == 0 ? previous_duration : duration;
+	star.update_speed(std::ldexp(ending, -star.rung) * closing);
+
+	star.update_rung(std::abs(duration), max_rung, substep, accuracy, length);
+	star.update_speed(std::ldexp(duration, -star.rung) * opening);
+}
+
+
+
+// Dérive d'un sous-pas
+
+void Integrator::drift(Star &star) const {
+	star.update_position(duration / static_cast<double>(substeps()));
+}
@@ -2,30 +2,52 @@
 #include "vector.h"
 #include "utils.h"
 #include "block.h"
+#include "palette.h"
+#include "render.h"
+#include "fmm.h"
+#include "pm.h"
+#include "direct.h"
+#include "diagnostics.h"
+#include "integrator.h"
+#include "density.h"
+#include "potential.h"
+#include "scenario.h"
+#include "domain.h"
+#include "numa.h"
+#include "compute.h"
+#include "perf.h"
 #include <ctime>
 
-SDL_Window *window = nullptr;
-
-SDL_Renderer *renderer = nullptr;
-
 struct MutexRange {
 	Star::range part;
+	std::vector<std::size_t> escaped; // Positions (dans le conteneur) des étoiles sorties pendant ce pas
+	Bounding_box box;                 // Boîte englobante des étoiles restantes, après déplacement
+	int finest_rung = 0;              // Plus grand niveau de pas de temps de la partie
+	const Block *tree = nullptr;      // Arbre parcouru par le thread (copie sur son noeud NUMA)
+	double busy = 0.;                 // Temps passé à calculer depuis le dernier rapport d'occupation (en secondes)
 	std::atomic<int> ready = 0;
 };
 
-template<size_t N>
-void make_partitions(std::array<MutexRange, N> &mutparts, Star::range alive_galaxy, const size_t total) {
-	const size_t n_per_part = total / N;
-	auto current_it = alive_galaxy.begin, prev_it = alive_galaxy.begin;
+// Parties de même coût (et non plus de même nombre d'étoiles) : prefix est un tampon réutilisé d'un appel à l'autre
+template<typename Cost>
+void make_partitions(std::vector<MutexRange> &mutparts, Star::range alive_galaxy, std::vector<double> &prefix, Cost cost) {
+	const std::size_t N = mutparts.size();
+	double total = 0.;
+	prefix.clear();
+	for (auto it = alive_galaxy.begin; it != alive_galaxy.end; ++it)
+		prefix.push_back(total += cost(*it));
+
+	auto prev_it = alive_galaxy.begin;
 	for (size_t i = 0; i < N - 1; ++i) {
-		for (size_t i_it = 0; i_it < n_per_part; ++i_it, ++current_it);
+		const auto cut = std::lower_bound(prefix.begin(), prefix.end(), total * double(i + 1) / double(N)) - prefix.begin();
+		const auto current_it = std::max(prev_it, alive_galaxy.begin + std::min<std::ptrdiff_t>(cut + 1, prefix.size()));
 
 		mutparts[i].part = { prev_it, current_it };
 		mutparts[i].ready = 1;
 
 		prev_it = current_it;
 	}
-	mutparts.back().part = { current_it, alive_galaxy.end };
+	mutparts.back().part = { prev_it, alive_galaxy.end };
 	mutparts.back().ready = 1;
 }
 
@@ -38,22 +60,51 @@ int main(int argc, char *argv[]) {
 
 	constexpr double area = 1000. * LIGHT_YEAR;                // Taille de la zone d'apparition des étoiles (en années lumière)
 	constexpr double galaxy_thickness = 0.05;    // Epaisseur de la galaxie (en "area")
+	constexpr double escape_radius = 0. * LIGHT_YEAR;    // Distance au centre de gravité au-delà de laquelle une étoile est retirée (0 : jamais)
 
 	constexpr int stars_number = 50000;        // Nombre d'étoiles
 	constexpr double initial_speed = 10000.;        // Vitesse initiale des d'étoiles (en mètres par seconde)
+	constexpr bool equilibrium = true;              // Vitesses circulaires calculées à partir de la masse intérieure (sinon initial_speed pour toutes)
+	constexpr double velocity_dispersion = 0.05;    // Équilibre : dispersion des vitesses (en fraction de la vitesse circulaire)
 
 	constexpr bool is_black_hole = false;        // Présence d'un trou noir
 	constexpr double black_hole_mass = 0.;        // Masse du trou noir (en masses solaires)
+	const std::vector<External_potential> external_potentials = {}; // Potentiels analytiques (halo, disque), ex. { { nfw_halo, 1e10 * SOLAR_MASS, 300. * LIGHT_YEAR } }
+	const std::vector<Galaxy_model> galaxies = {    // Galaxies du scénario (la première reprend les paramètres ci-dessus), ex. collision :
+		{ stars_number, area, galaxy_thickness, initial_speed, is_black_hole, black_hole_mass, equilibrium, velocity_dispersion } // + { -2000. * LIGHT_YEAR, 0., 0. }, { 50000., 0., 0. }, 0.5, 0.
+	};                                              // Ou conditions initiales lues : { 0, 0., 0., 0., false, 0., false, 0., {}, {}, 0., 0., "galaxie.txt" }
+	constexpr std::uint64_t seed = 1;               // Graine de la génération des étoiles (même scénario quel que soit n_thread)
 
 	constexpr double step = 100000. * YEAR;                // Pas de temps de la simulation (en années de simulation)
-	constexpr double precision = 1.;                // Précision du calcul de l'accélération (algorithme de Barnes-Hut)
-	constexpr bool verlet_integration = true;    // Utiliser l'intégration de Verlet au lieu de la méthode d'Euler
+	constexpr int max_rung = 4;                    // Niveaux de pas individuels : une étoile avance de step / 2^rung (0 <= rung <= max_rung)
+	constexpr double timestep_accuracy = 0.025;    // Critère du pas individuel : sqrt(2 * timestep_accuracy * timestep_length / accélération)
+	constexpr double timestep_length = 1. * LIGHT_YEAR;    // Longueur caractéristique du critère du pas individuel
+	constexpr double precision = 1.;                // Précision du calcul de l'accélération (angle d'ouverture de l'arbre)
+	constexpr bool use_quadrupole = true;           // Ajouter le moment quadripolaire des blocs (Barnes-Hut) : angle d'ouverture plus grand à erreur égale
+	constexpr std::size_t prefetch_distance = 4;    // Parcours de l'arbre : blocs de la pile et étoiles demandés au cache autant de visites à l'avance (0 : aucun)
+	Solver solver = barnes_hut;                     // Calcul de la gravité (barnes_hut, fast_multipole, tree_pm ou direct_sum), choisi à l'exécution
+	constexpr int fmm_order = 3;                    // Ordre des développements de la méthode multipolaire rapide
+	constexpr std::size_t pm_grid_size = 64;        // TreePM : noeuds par côté de la grille longue portée (puissance de deux)
+	constexpr double pm_split_cells = 1.25;         // TreePM : rayon de séparation entre grille et arbre (en cellules de la grille)
+	constexpr Scheme scheme = leapfrog;          // Schéma d'intégration (euler, leapfrog ou forest_ruth : ordre 4, trois forces par pas)
+	constexpr std::size_t diagnostics_interval = 0; // Mesures de précision (énergie, moments, erreur de la force) tous les N pas (0 : jamais)
+	constexpr std::size_t diagnostics_samples = 256; // Étoiles comparées à la somme directe lors des mesures
+	constexpr std::size_t utilization_interval = 0; // Rapport d'occupation des threads tous les N pas (0 : jamais)
+	constexpr bool memory_report = false;           // Octets par étoile (étoiles, arbre, identifiants) après la construction du premier arbre
+	constexpr std::size_t tlb_interval = 0;         // Défauts de TLB et de page par étoile, mémoire en grandes pages, tous les N pas (0 : jamais)
 
 	constexpr View view = xy;                    // Type de vue (default_view, xy, xz ou yz)
 	constexpr double zoom = 800.;                // Taille de "area" (en pixel)
-	constexpr bool real_colors = false;        // Activer la couleur réelle des étoiles
+	constexpr Color_mode color_mode = density_colors;    // Coloration des étoiles (density_colors, heat_colors ou real_colors)
+	constexpr std::size_t density_interval = 0;  // Densité par les plus proches voisins tous les N pas (0 : sous-produit du calcul de la gravité)
+	constexpr std::size_t density_neighbours = 32;    // Nombre de voisins de l'estimation de la densité
+	constexpr double density_scale = 300000.;    // Facteur de la palette pour cette densité (en années-lumière cube par masse solaire)
 
 	constexpr std::size_t n_thread = 4; // Le nombre de thread utilisé pour le calcul.
+	constexpr Backend backend = std_threads; // Boucles parallèles : threads du projet (std_threads), algorithmes parallèles de la STL (parallel_stl, TBB) ou openmp
+	constexpr std::size_t nb_ranks = 1; // Processus se partageant les étoiles (décomposition en domaines, Barnes-Hut seulement)
+	constexpr bool numa_aware = false;  // Threads fixés aux coeurs, étoiles et copie de l'arbre sur le noeud NUMA de chaque thread
+	constexpr Page_mode page_mode = standard_pages; // Pages des étoiles et de l'arbre (standard_pages, transparent_huge_pages ou hugetlbfs_pages : moins de défauts de TLB)
 
 
 
@@ -61,15 +112,6 @@ int main(int argc, char *argv[]) {
 
 
 
-	SDL_Init(SDL_INIT_VIDEO);
-
-//	window = nullptr; // useless : déjà fait auparavant.
-//	renderer = nullptr; // même raison.
-
-	SDL_CreateWindowAndRenderer(WIDTH, HEIGHT, 0, &window, &renderer);
-	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-	SDL_SetWindowTitle(window, "Galaxy simulation");
-	SDL_Event event;
 /* Inutile -> il vaut mieux laisser en commentaire et laisser à l'utilisateur le contrôle. Tant pis pour lui si ça foire. */
 //	if (area < 0.1) area = 0.1;
 //	if (galaxy_thickness > 1.) galaxy_thickness = 1.;
@@ -84,36 +126,135 @@ int main(int argc, char *argv[]) {
 //	area *= LIGHT_YEAR;
 //	step *= YEAR;
 
+	// En premier : les rangs sont des copies du processus, créées avant tout thread
+	const auto transport = launch_ranks(nb_ranks);
+	set_page_mode(page_mode); // Avant la première étoile
+
+	// Ouverts avant tout thread (pool du backend, noeuds NUMA, workers) : ils comptent aussi dans les leurs
+	const auto tlb_counter = tlb_interval > 0 ? std::make_unique<Perf_counter>(tlb_misses) : std::make_unique<Perf_counter>();
+	const auto fault_counter = tlb_interval > 0 ? std::make_unique<Perf_counter>(page_faults) : std::make_unique<Perf_counter>();
+
+	const Compute compute(backend, n_thread);
+	Domain domain(*transport);
+	domain.compute = compute;
+	const bool is_master = transport->rank() == 0; // Seul le rang 0 affiche la simulation
+
+	if (domain.is_distributed()) // Les autres solveurs et les mesures ne connaissent que les étoiles locales
+		solver = barnes_hut;
+
 	Star::container galaxy;
 	Block block;
+	Fmm fmm(fmm_order);
+	Particle_mesh pm(solver == tree_pm ? pm_grid_size : 0, pm_split_cells);
+	Direct direct;
 
-	initialize_galaxy(galaxy, stars_number, area, initial_speed, step, is_black_hole, black_hole_mass, galaxy_thickness);
+	const External_field external(external_potentials);
+
+	if (!create_scenario(galaxy, galaxies, seed, compute, &external))
+		return EXIT_FAILURE;
+
+	if (galaxy.size() > std::numeric_limits<Star::index_type>::max()) { // Mode compact : indices sur 32 bits
+		std::cerr << "Trop d'étoiles pour des indices sur " << 8 * sizeof(Star::index_type) << " bits" << std::endl;
+		return EXIT_FAILURE;
+	}
 
 	Star::range alive_galaxy = { galaxy.begin(), galaxy.end() };
-	double current_step = 1.;
+	const std::size_t nb_ids = galaxy.size(); // Identifiants communs à tous les rangs
+	std::vector<Star::index_type> slots(nb_ids); // Identifiant (Star::index) -> position dans le conteneur
+	std::vector<std::size_t> escaped;
+	std::iota(slots.begin(), slots.end(), 0);
+
+	if (domain.is_distributed())
+		domain.distribute(galaxy, alive_galaxy, slots);
+
+	// Placement possible avec les threads du projet seulement : ceux de la STL ne sont pas fixés à un coeur
+	Numa_placement numa(numa_aware && compute.backend == std_threads ? detect_numa_nodes() : std::vector<Numa_node>(), n_thread);
+	numa.pin_main();
+	numa.first_touch(galaxy);
+
+	const glm::dvec3 &mass_center = domain.is_distributed() ? domain.mass_center : block.mass_center; // Centre de toute la galaxie
+	const Palette *palette = select_palette(color_mode); // nullptr : couleurs réelles, fixées à l'initialisation
+	Palette density_palette;
+	Density_estimator density_estimator;
+	density_estimator.neighbours = density_neighbours;
+
+	if (palette && density_interval > 0) { // La densité des voisins n'a pas la même échelle que celle du parcours de l'arbre
+		density_palette = *palette;
+		density_palette.density_scale = density_scale;
+		palette = &density_palette;
+	}
+	Integrator integrator(scheme, step, max_rung, timestep_accuracy, timestep_length);
+	const std::size_t substeps = integrator.substeps(); // Chaque étape du schéma est découpée en sous-pas du niveau le plus fin
+	std::size_t stage = 0, substep = 0;
 	bool stop_threads = false;
-	const auto update_stars = [&block, precision, verlet_integration, step, area, real_colors, &stop_threads, &current_step](MutexRange *mutpart) {
-		using namespace std::chrono_literals;
-		while (mutpart->ready != 1)
-			std::this_thread::sleep_for(2ms);
+	std::size_t frame = 0;
+	Diagnostics diagnostics;
+	diagnostics.samples = diagnostics_samples;
+	diagnostics.external = &external;
+
+	// Accélération d'une étoile pour les solveurs qui la calculent étoile par étoile (les autres l'ont déjà calculée pour toutes)
+	// Densité du parcours inutile quand celle des plus proches voisins la remplace
+	constexpr bool tree_density = density_interval == 0;
+	const auto star_acceleration = [&solver, &pm, &domain, precision, use_quadrupole, prefetch_distance](Star &star, const Block &tree) {
+		if (solver == barnes_hut) {
+			star.update_acceleration_and_density(precision, tree, use_quadrupole, 0., prefetch_distance, tree_density);
+			if (domain.ghost_root.nb_stars > 0) // Étoiles des autres rangs
+				star.acceleration += force_and_density_calculation(precision, star, domain.ghost_root, use_quadrupole, 0., prefetch_distance, tree_density);
+		} else if (solver == tree_pm) {
+			star.update_acceleration_and_density(precision, tree, use_quadrupole, pm.get_split_radius(), prefetch_distance, tree_density); // Courte portée
+			star.acceleration += pm.acceleration(star.position);
+		}
+	};
 
-		while (!stop_threads) {
-			for (auto it_star = mutpart->part.begin; it_star != mutpart->part.end; ++it_star) // Boucle sur les étoiles de la galaxie
-			{
-				it_star->update_acceleration_and_density(precision, block);
+	// Sous-pas d'une partie : poussée des étoiles actives, dérive de toutes, puis sorties et boîte au dernier sous-pas
+	const auto advance = [&galaxy, &slots, &mass_center, &star_acceleration, &external, &integrator, substeps, escape_radius, prefetch_distance, &stage, &substep](MutexRange &mutpart) {
+		const bool last_substep = stage + 1 == integrator.stages() && substep + 1 == substeps;
+		mutpart.escaped.clear();
+		mutpart.box = Bounding_box();
+		mutpart.finest_rung = 0;
+		const auto start = std::chrono::steady_clock::now();
+
+		for (auto it_star = mutpart.part.begin; it_star != mutpart.part.end; ++it_star) // Boucle sur les étoiles de la galaxie
+		{
+			if (prefetch_distance > 0 && static_cast<std::size_t>(mutpart.part.end - it_star) > prefetch_distance)
+				prefetch(*(it_star + prefetch_distance)); // Étoile traitée prefetch_distance itérations plus tard
+
+			// Seules les étoiles dont le pas commence à ce sous-pas recalculent leur force
+			if (integrator.is_active(*it_star, substep)) {
+				star_acceleration(*it_star, *mutpart.tree);
+				if (!external.empty())
+					it_star->acceleration += external.acceleration(it_star->position);
+
+				integrator.kick(*it_star, substep);
+			}
 
-				if (!verlet_integration)
-					it_star->update_speed(step * current_step, area);
+			integrator.drift(*it_star); // Toutes les étoiles dérivent à chaque sous-pas
+			mutpart.finest_rung = std::max(mutpart.finest_rung, static_cast<int>(it_star->rung));
 
-				it_star->update_position(step * current_step, verlet_integration);
+			if (!last_substep)
+				continue;
 
-				if (!is_in(block, *it_star))
-					it_star->is_alive = false;
+			const auto position = static_cast<std::size_t>(std::distance(galaxy.begin(), it_star));
+			slots[it_star->index] = position; // La construction de l'arbre réordonne les étoiles
 
-				else if (!real_colors)
-					it_star->update_color();
-			}
+			if (escape_radius > 0. && glm::distance(it_star->position, mass_center) > escape_radius) {
+				it_star->is_alive = false;
+				mutpart.escaped.push_back(position);
+			} else
+				mutpart.box.extend(it_star->position); // Réduction min/max répartie entre les threads
+		}
 
+		mutpart.busy += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	// Worker du backend std_threads : une partie par sous-pas, donnée par le thread principal
+	const auto update_stars = [&advance, &stop_threads](MutexRange *mutpart) {
+		using namespace std::chrono_literals;
+		while (mutpart->ready != 1)
+			std::this_thread::sleep_for(2ms);
+
+		while (!stop_threads) {
+			advance(*mutpart);
 			mutpart->ready = 2;
 
 			while (mutpart->ready != 1 && !stop_threads)
@@ -121,62 +262,168 @@ int main(int argc, char *argv[]) {
 		}
 	};
 
+	// Une partie par worker, ou plusieurs par thread pour les backends à tâches : leur ordonnanceur les équilibre
 	std::array<std::thread, n_thread> mythreads;
-	std::array<MutexRange, n_thread> mutparts;
+	std::vector<MutexRange> mutparts(compute.backend == std_threads ? n_thread : 8 * compute.n_thread);
 
-	for (int i = 0; i < mythreads.size(); ++i) {
+	for (std::size_t i = 0; i < mutparts.size(); ++i) {
 		mutparts[i].ready = 0;
-		mythreads[i] = std::thread(update_stars, &mutparts[i]);
+		mutparts[i].tree = &numa.tree(block, i);
+
+		if (compute.backend == std_threads) {
+			mythreads[i] = std::thread(update_stars, &mutparts[i]);
+			numa.pin(mythreads[i], i);
+		}
 	}
 
-	auto total_galaxy = std::distance(alive_galaxy.begin, alive_galaxy.end);
-	auto t0 = std::chrono::steady_clock::now();
+	// Le rendu et les évènements SDL ont leur propre thread : la présentation (vsync) ne ralentit plus le calcul.
+	std::atomic<bool> quit{ false };
+	Triple_buffer<Snapshot> snapshots;
+	std::thread render_thread;
+	if (is_master)
+		render_thread = std::thread(render_loop, std::ref(snapshots), palette, std::ref(quit), area, zoom, view);
+
+	std::vector<double> partition_costs;
+	double parallel_time = 0.; // Durée des sous-pas vue par le thread principal, depuis le dernier rapport d'occupation
+	auto root_box = bounding_box(alive_galaxy, compute);
 
-	while (true) // Boucle du pas de temps de la simulation
+	while (!domain.any(quit)) // Boucle du pas de temps de la simulation (tous les rangs s'arrêtent ensemble)
 	{
-		if (SDL_PollEvent(&event) == 0) {
-			using namespace std::chrono_literals;
-			namespace chrono = std::chrono;
-			create_blocks(area, block, alive_galaxy);
+		using namespace std::chrono_literals;
+		create_blocks(root_box, block, alive_galaxy, compute);
+		numa.replicate(block);
+
+		if (memory_report && frame == 0)
+			print_memory(std::cout, galaxy, block, slots);
+		int finest_rung = max_rung;
+
+		if (density_interval > 0 && frame % density_interval == 0) // Arbre tout juste construit : boîtes exactes pour la recherche
+			density_estimator.estimate(block, alive_galaxy, nb_ids, compute);
+
+		for (stage = 0; stage < integrator.stages(); ++stage) {
+			integrator.begin_stage(stage);
+
+			for (substep = 0; substep < substeps; ++substep) {
+				if (stage > 0 || substep > 0)
+					numa.refit(block); // L'arbre n'est reconstruit qu'une fois par pas, les sous-pas ne font que le remettre à jour
+
+				if (substep == 0 && domain.is_distributed()) // Fantômes figés pendant les sous-pas de l'étape
+					domain.exchange_essential(block, alive_galaxy, precision);
+
+				// Toutes les étoiles, les workers n'utilisent que celles qui commencent un pas (s'il y en a à ce sous-pas)
+				if (substep % rung_period(finest_rung, max_rung) == 0) {
+					if (solver == fast_multipole)
+						fmm.solve(block, precision, compute);
+					else if (solver == tree_pm)
+						pm.solve(block, alive_galaxy, compute);
+					else if (solver == direct_sum) {
+						direct.load(alive_galaxy);
+						direct.solve(alive_galaxy, compute);
+					}
+				}
+
+				// Positions et arbre à jour, vitesses pas encore poussées : seul moment où toutes les mesures sont cohérentes
+				if (stage == 0 && substep == 0 && diagnostics_interval > 0 && frame % diagnostics_interval == 0 && !domain.is_distributed()) {
+					diagnostics.measure(alive_galaxy, block, precision, [&star_acceleration, &block](Star star) {
+						star_acceleration(star, block);
+						return star.acceleration;
+					}, compute);
+					diagnostics.print(std::cout, frame);
+				}
+
+				// Coût d'une étoile : ses interactions du dernier parcours si elle calcule sa force, sinon la seule dérive
+				const auto start = std::chrono::steady_clock::now();
+				make_partitions(mutparts, alive_galaxy, partition_costs, [&integrator, substep](const Star &star) {
+					return integrator.is_active(star, substep) ? 1. + star.interactions : 1.;
+				});
+				if (compute.backend != std_threads)
+					compute.tasks(mutparts.size(), [&advance, &mutparts](std::size_t i) {
+						advance(mutparts[i]);
+						mutparts[i].ready = 2;
+					});
+
+				finest_rung = 0;
+				for (auto &mp : mutparts) {
+					while (mp.ready != 2)
+						std::this_thread::sleep_for(1ms);
+
+					finest_rung = std::max(finest_rung, mp.finest_rung);
+				}
+				parallel_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			}
+		}
+		++frame;
+
+		if (utilization_interval > 0 && frame % utilization_interval == 0) {
+			// Part du temps des sous-pas passée à calculer par chaque thread (chaque partie avec un backend à tâches) : un thread peu occupé attend les autres
+			double max_busy = 0., mean_busy = 0.;
+			std::cout << "[threads] pas " << frame << " | occupation";
 
-			make_partitions<n_thread>(mutparts, alive_galaxy, total_galaxy);
 			for (auto &mp : mutparts) {
-				while (mp.ready != 2)
-					std::this_thread::sleep_for(1ms);
+				std::cout << " " << std::fixed << std::setprecision(1) << 100. * mp.busy / parallel_time << "%";
+				max_busy = std::max(max_busy, mp.busy);
+				mean_busy += mp.busy / mutparts.size();
+				mp.busy = 0.;
 			}
-			{
-				const auto prev_end = alive_galaxy.end;
-				alive_galaxy.end = std::partition(alive_galaxy.begin, alive_galaxy.end, [](const Star &star) { return star.is_alive; });
-				total_galaxy -= std::distance(alive_galaxy.end, prev_end);
+
+			std::cout << " | déséquilibre (max / moyenne) " << std::setprecision(3) << max_busy / mean_busy << std::defaultfloat << std::endl;
+			parallel_time = 0.;
+		}
+
+		if (tlb_interval > 0 && frame % tlb_interval == 0) {
+			// Par étoile et par pas : un défaut de TLB coûte un parcours de la table des pages, que les grandes pages raccourcissent
+			const double per_star = 1. / (static_cast<double>(tlb_interval) * std::max<std::size_t>(alive_galaxy.end - alive_galaxy.begin, 1));
+			const auto tlb = tlb_counter->read();
+			const auto faults = fault_counter->read();
+
+			std::cout << "[pages] pas " << frame << " | défauts de TLB ";
+			if (tlb_counter->is_available())
+				std::cout << std::fixed << std::setprecision(2) << tlb * per_star << " par étoile";
+			else
+				std::cout << "non mesurés (compteur matériel indisponible)";
+
+			std::cout << " | défauts de page " << std::fixed << std::setprecision(3) << faults * per_star << " par étoile"
+					  << " | grandes pages " << std::setprecision(1) << huge_page_bytes() / 1048576. << " Mo (plages de l'arbre " << arena_slabs() << ")"
+					  << std::defaultfloat << std::endl;
+		}
+
+		{
+			// Seules les étoiles sorties sont déplacées, au lieu de repartitionner toute la galaxie à chaque pas.
+			escaped.clear();
+			root_box = Bounding_box();
+			for (const auto &mp : mutparts) {
+				escaped.insert(escaped.end(), mp.escaped.begin(), mp.escaped.end());
+				root_box.merge(mp.box);
 			}
 
-			SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
-			SDL_RenderClear(renderer);
+			remove_escaped(galaxy, alive_galaxy, escaped, slots);
+		}
+
+		const auto *densities = density_interval > 0 ? &density_estimator.densities : nullptr;
 
-			draw_stars(alive_galaxy, block.mass_center, area, zoom, view);
+		if (domain.is_distributed()) {
+			// Nouveaux séparateurs puis migration : les étoiles ont bougé pendant le pas
+			domain.balance(alive_galaxy);
+			domain.migrate(galaxy, alive_galaxy, slots);
+			root_box = bounding_box(alive_galaxy, compute);
 
-			SDL_RenderPresent(renderer);
-			SDL_GL_SwapWindow(window);
+			auto all_stars = domain.gather(alive_galaxy, densities);
+			if (is_master)
+				snapshots.back().capture({ all_stars.begin(), all_stars.end() }, mass_center, nullptr, compute);
+		} else
+			snapshots.back().capture(alive_galaxy, mass_center, densities, compute);
 
-			auto t1 = chrono::steady_clock::now();
-			chrono::duration<double, std::ratio<1, 60>> duree = t1 - t0;
-			t0 = t1;
-			current_step = duree.count();
-		} else if (event.type == SDL_QUIT || (event.type == SDL_KEYDOWN || event.key.keysym.scancode == SDL_SCANCODE_ESCAPE))
-			break;
+		if (is_master)
+			snapshots.publish();
 	}
 
 	stop_threads = true;
 	for (auto &thr : mythreads) {
-		thr.join();
+		if (thr.joinable())
+			thr.join();
 	}
 
-	if (renderer)
-		SDL_DestroyRenderer(renderer);
-
-	if (window)
-		SDL_DestroyWindow(window);
-
-	SDL_Quit();
+	if (render_thread.joinable())
+		render_thread.join();
 	return EXIT_SUCCESS;
 }
\ No newline at end of file
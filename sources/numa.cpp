@@ -0,0 +1,289 @@
+#include "numa.h"
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Lit une liste de coeurs au format de /sys ("0-3,8-11")
+
+static std::vector<int> parse_cpu_list(const std::string &list) {
+	std::vector<int> cpus;
+	std::istringstream stream(list);
+	std::string range;
+
+	while (std::getline(stream, range, ',')) {
+		const auto dash = range.find('-');
+
+		try {
+			const int first = std::stoi(range.substr(0, dash));
+			const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+
+			for (int cpu = first; cpu <= last; ++cpu)
+				cpus.push_back(cpu);
+		} catch (const std::exception &) {} // Fin de ligne vide
+	}
+
+	return cpus;
+}
+
+
+
+// Fixe un thread sur un ensemble de coeurs
+
+static void set_affinity([[maybe_unused]] std::thread::native_handle_type handle, [[maybe_unused]] const std::vector<int> &cpus) {
+#ifdef __linux__
+	cpu_set_t set;
+	CPU_ZERO(&set);
+
+	for (const int cpu : cpus)
+		CPU_SET(cpu, &set);
+
+	pthread_setaffinity_np(handle, sizeof(set), &set);
+#endif
+}
+
+
+
+// Fixe le thread appelant sur un ensemble de coeurs
+
+static void pin_current_thread([[maybe_unused]] const std::vector<int> &cpus) {
+#ifdef __linux__
+	set_affinity(pthread_self(), cpus);
+#endif
+}
+
+
+
+// Lit la topologie NUMA
+
+std::vector<Numa_node> detect_numa_nodes() {
+	std::vector<Numa_node> nodes;
+
+	// Les numéros de noeuds peuvent avoir des trous : on essaie tous ceux de /sys/devices/system/node/possible
+	std::ifstream possible("/sys/devices/system/node/possible");
+	std::string list;
+
+	if (!std::getline(possible, list))
+		return nodes;
+
+	for (const int id : parse_cpu_list(list)) {
+		std::ifstream file("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+		std::string cpus;
+
+		if (std::getline(file, cpus)) {
+			Numa_node node;
+			node.id = id;
+			node.cpus = parse_cpu_list(cpus);
+
+			if (!node.cpus.empty()) // Noeud de mémoire seule
+				nodes.push_back(node);
+		}
+	}
+
+	return nodes;
+}
+
+
+
+// Prépare le placement (une copie de l'arbre par noeud sauf le premier)
+
+Numa_placement::Numa_placement(const std::vector<Numa_node> &nodes, std::size_t n_thread) {
+	this->nodes = nodes;
+	this->n_thread = std::max<std::size_t>(n_thread, 1);
+	replicas.resize(nodes.size() > 1 ? nodes.size() - 1 : 0);
+
+	for (std::size_t node = 1; node < nodes.size(); ++node) {
+		helpers.push_back(std::make_unique<Node_helper>());
+
+		helpers.back()->thread = std::thread([&helper = *helpers.back(), node, cpus = nodes[node].cpus]() {
+			pin_current_thread(cpus); // Avant toute allocation
+			std::unique_lock lock(helper.mutex);
+
+			while (true) {
+				helper.wake.wait(lock, [&helper]() { return helper.stop || helper.task; });
+
+				if (helper.stop)
+					return;
+
+				(*helper.task)(node);
+				helper.task = nullptr;
+				helper.finished.notify_all();
+			}
+		});
+	}
+}
+
+
+
+// Arrête les threads des noeuds
+
+Numa_placement::~Numa_placement() {
+	for (auto &helper : helpers) {
+		{
+			std::lock_guard lock(helper->mutex);
+			helper->stop = true;
+		}
+
+		helper->wake.notify_all();
+		helper->thread.join();
+	}
+}
+
+
+
+// Indique si le placement est actif
+
+bool Numa_placement::is_active() const {
+	return !nodes.empty();
+}
+
+
+
+// Noeud d'un worker (blocs contigus de threads)
+
+std::size_t Numa_placement::node_of(std::size_t thread) const {
+	return thread * nodes.size() / n_thread;
+}
+
+
+
+// Fixe le thread principal sur le premier noeud
+
+void Numa_placement::pin_main() const {
+	if (is_active())
+		pin_current_thread(nodes.front().cpus);
+}
+
+
+
+// Fixe un worker à un coeur de son noeud
+
+void Numa_placement::pin(std::thread &thread, std::size_t index) const {
+	if (is_active())
+		set_affinity(thread.native_handle(), { worker_cpu(index) });
+}
+
+
+
+// Coeur d'un worker : les threads d'un noeud se partagent ses coeurs dans l'ordre
+
+int Numa_placement::worker_cpu(std::size_t index) const {
+	const std::size_t node = node_of(index);
+	std::size_t rank_in_node = 0;
+
+	for (std::size_t t = 0; t < index; ++t)
+		rank_in_node += node_of(t) == node;
+
+	const auto &cpus = nodes[node].cpus;
+	return cpus[rank_in_node % cpus.size()];
+}
+
+
+
+// Réécrit les étoiles depuis leurs workers
+
+void Numa_placement::first_touch(Star::container &galaxy) const {
+#ifdef __linux__
+	if (!is_active() || galaxy.empty())
+		return;
+
+	const Star::container copy = galaxy;
+
+	// Pages entièrement contenues dans le conteneur rendues au système : la prochaine écriture choisit leur noeud
+	// (grandes pages de l'arène : rendues entières, hugetlbfs refuse le reste et une page transparente serait coupée)
+	const auto page = static_cast<std::uintptr_t>(arena_page_size());
+	const auto begin = (reinterpret_cast<std::uintptr_t>(galaxy.data()) + page - 1) / page * page;
+	const auto end = reinterpret_cast<std::uintptr_t>(galaxy.data() + galaxy.size()) / page * page;
+
+	if (end <= begin)
+		std::cerr << "Étoiles sur moins d'une page entière : laissées sur le noeud du thread principal" << std::endl;
+	else if (madvise(reinterpret_cast<void *>(begin), end - begin, MADV_DONTNEED) != 0)
+		std::cerr << "madvise impossible (" << std::strerror(errno) << ") : étoiles laissées sur le noeud du thread principal" << std::endl;
+
+	// Mêmes parties que make_partitions
+	const std::size_t n_per_part = galaxy.size() / n_thread;
+	std::vector<std::thread> threads;
+
+	for (std::size_t t = 0; t < n_thread; ++t) {
+		const std::size_t first = t * n_per_part, last = t + 1 == n_thread ? galaxy.size() : (t + 1) * n_per_part;
+
+		threads.emplace_back([&galaxy, &copy, first, last, cpu = worker_cpu(t)]() {
+			pin_current_thread({ cpu }); // Avant la première écriture
+			for (std::size_t i = first; i < last; ++i)
+				new(&galaxy[i]) Star(copy[i]); // Page remise à zéro : l'étoile est reconstruite, pas affectée
+		});
+	}
+
+	for (auto &thread : threads)
+		thread.join();
+#endif
+}
+
+
+
+// Lance une tâche par noeud : le thread appelant fait celle du premier, le thread du noeud celle des autres
+
+void Numa_placement::on_nodes(const std::function<void(std::size_t)> &task) const {
+	for (const auto &helper : helpers) {
+		{
+			std::lock_guard lock(helper->mutex);
+			helper->task = &task;
+		}
+
+		helper->wake.notify_all();
+	}
+
+	task(0);
+
+	for (const auto &helper : helpers) {
+		std::unique_lock lock(helper->mutex);
+		helper->finished.wait(lock, [&helper]() { return !helper->task; });
+	}
+}
+
+
+
+// Copie l'arbre sur chaque autre noeud
+
+void Numa_placement::replicate(const Block &block) {
+	if (replicas.empty())
+		return;
+
+	on_nodes([this, &block](std::size_t node) {
+		if (node > 0)
+			replicas[node - 1] = block;
+	});
+}
+
+
+
+// Remet à jour l'arbre et ses copies
+
+void Numa_placement::refit(Block &block) {
+	if (replicas.empty()) {
+		block.refit();
+		return;
+	}
+
+	on_nodes([this, &block](std::size_t node) {
+		if (node == 0)
+			block.refit();
+		else
+			replicas[node - 1].refit();
+	});
+}
+
+
+
+// Arbre parcouru par un worker
+
+const Block &Numa_placement::tree(const Block &block, std::size_t thread) const {
+	const std::size_t node = is_active() ? node_of(thread) : 0;
+
+	return node == 0 ? block : replicas[node - 1];
+}
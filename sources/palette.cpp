@@ -0,0 +1,89 @@
+#include "palette.h"
+
+// Construit la table à partir d'un générateur
+
+Palette::Palette(const std::function<glm::u8vec3(std::size_t)> &generator, const double &density_scale) {
+	for (std::size_t i = 0; i < size; ++i)
+		colors[i] = generator(i);
+
+	this->density_scale = density_scale;
+}
+
+
+
+// Donne l'indice de la table correspondant à une densité (borné en flottant : pas de dépassement lors de la conversion)
+
+std::size_t Palette::index(const double &density) const {
+	return static_cast<std::size_t>(std::min(std::max(density * density_scale, 0.), static_cast<double>(size - 1)));
+}
+
+
+
+// Colore un tableau de densités à partir de la table
+
+void Palette::apply(const std::vector<double> &densities, std::vector<glm::u8vec3> &colors, const Compute &compute) const {
+	colors.resize(densities.size());
+
+	compute.for_ranges(densities.size(), [this, &densities, &colors](std::size_t, std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i)
+			colors[i] = this->colors[index(densities[i])];
+	});
+}
+
+
+
+// Dégradé historique : noir -> bleu -> cyan -> blanc
+
+Palette blue_palette() {
+	return Palette([](std::size_t i) {
+		const auto level = static_cast<std::uint8_t>(i % 255);
+
+		if (i < 255)
+			return glm::u8vec3{ 0, 0, level };
+
+		if (i < 255 * 2)
+			return glm::u8vec3{ 0, level, 255 };
+
+		return glm::u8vec3{ static_cast<std::uint8_t>(std::min<std::size_t>(i - 255 * 2, 255)), 255, 255 };
+	}, 2.);
+}
+
+
+
+// Dégradé thermique : noir -> rouge -> jaune -> blanc
+
+Palette heat_palette() {
+	return Palette([](std::size_t i) {
+		const auto level = static_cast<std::uint8_t>(i % 255);
+
+		if (i < 255)
+			return glm::u8vec3{ level, 0, 0 };
+
+		if (i < 255 * 2)
+			return glm::u8vec3{ 255, level, 0 };
+
+		return glm::u8vec3{ 255, 255, static_cast<std::uint8_t>(std::min<std::size_t>(i - 255 * 2, 255)) };
+	}, 2.);
+}
+
+
+
+// Donne la palette d'un mode de coloration (construite une seule fois)
+
+const Palette *select_palette(Color_mode mode) {
+	static const Palette blue = blue_palette();
+	static const Palette heat = heat_palette();
+
+	switch (mode) {
+		case density_colors:
+			return &blue;
+
+		case heat_colors:
+			return &heat;
+
+		case real_colors:
+			break;
+	}
+
+	return nullptr;
+}
@@ -0,0 +1,65 @@
+#include "perf.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Ouvre le compteur (indisponible en cas d'échec)
+
+Perf_counter::Perf_counter([[maybe_unused]] Perf_event event) {
+#ifdef __linux__
+	perf_event_attr attributes{};
+	attributes.size = sizeof(attributes);
+	attributes.inherit = 1;        // Threads créés ensuite compris
+	attributes.exclude_kernel = 1;
+	attributes.exclude_hv = 1;
+
+	if (event == tlb_misses) {
+		attributes.type = PERF_TYPE_HW_CACHE;
+		attributes.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+	} else {
+		attributes.type = PERF_TYPE_SOFTWARE;
+		attributes.config = PERF_COUNT_SW_PAGE_FAULTS;
+	}
+
+	descriptor = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+#endif
+}
+
+
+
+// Ferme le compteur
+
+Perf_counter::~Perf_counter() {
+#ifdef __linux__
+	if (descriptor >= 0)
+		close(descriptor);
+#endif
+}
+
+
+
+// Indique si le compteur a pu être ouvert
+
+bool Perf_counter::is_available() const {
+	return descriptor >= 0;
+}
+
+
+
+// Évènements depuis la dernière lecture
+
+std::uint64_t Perf_counter::read() {
+	std::uint64_t total = 0;
+
+#ifdef __linux__
+	if (descriptor < 0 || ::read(descriptor, &total, sizeof(total)) != sizeof(total))
+		return 0;
+#endif
+
+	const std::uint64_t events = total - last;
+	last = total;
+	return events;
+}
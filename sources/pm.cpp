@@ -0,0 +1,306 @@
+#include "pm.h"
+#include "utils.h"
+
+#ifdef GALAXY_FFTW
+#include <fftw3.h>
+#endif
+
+// Construit le solveur pour une taille de grille donnée
+
+Particle_mesh::Particle_mesh(std::size_t grid_size, const double &split_cells) {
+	if (grid_size == 0) // Solveur inutilisé : pas de grille allouée
+		return;
+
+	this->grid_size = std::max<std::size_t>(grid_size, 8);
+	while (this->grid_size & (this->grid_size - 1)) // Puissance de deux pour la FFT
+		++this->grid_size;
+
+	this->split_cells = split_cells;
+	padded_size = 2 * this->grid_size;
+	grid.resize(padded_size * padded_size * padded_size);
+
+	twiddles.resize(padded_size / 2);
+	for (std::size_t k = 0; k < twiddles.size(); ++k)
+		twiddles[k] = std::polar(1., -2. * PI * static_cast<double>(k) / static_cast<double>(padded_size));
+
+#ifdef GALAXY_FFTW
+	auto *data = reinterpret_cast<fftw_complex *>(grid.data());
+	const int n = static_cast<int>(padded_size);
+	forward_plan = fftw_plan_dft_3d(n, n, n, data, data, FFTW_FORWARD, FFTW_ESTIMATE);
+	backward_plan = fftw_plan_dft_3d(n, n, n, data, data, FFTW_BACKWARD, FFTW_ESTIMATE);
+#endif
+}
+
+
+
+// Libère les plans FFTW
+
+Particle_mesh::~Particle_mesh() {
+#ifdef GALAXY_FFTW
+	if (forward_plan) {
+		fftw_destroy_plan(static_cast<fftw_plan>(forward_plan));
+		fftw_destroy_plan(static_cast<fftw_plan>(backward_plan));
+	}
+#endif
+}
+
+
+
+// Indice d'un noeud de la grille de la FFT
+
+std::size_t Particle_mesh::padded_index(std::size_t i, std::size_t j, std::size_t k) const {
+	return (i * padded_size + j) * padded_size + k;
+}
+
+
+
+// Indice d'un noeud de la grille des masses
+
+std::size_t Particle_mesh::grid_index(std::size_t i, std::size_t j, std::size_t k) const {
+	return (i * grid_size + j) * grid_size + k;
+}
+
+
+
+// Trouve le noeud inférieur de la cellule contenant un point et la position relative du point dans cette cellule
+
+void Particle_mesh::locate(const glm::dvec3 &position, std::array<std::size_t, 3> &node, glm::dvec3 &fraction) const {
+	for (int axis = 0; axis < 3; ++axis) {
+		// Les noeuds 0, 1 et les deux derniers restent vides : marge des différences finies
+		const double u = std::clamp((position[axis] - origin[axis]) / cell_size, 2., static_cast<double>(grid_size) - 3.0001);
+		const double base = std::floor(u);
+		node[axis] = static_cast<std::size_t>(base);
+		fraction[axis] = u - base;
+	}
+}
+
+
+
+// FFT radix 2 en place d'une ligne contiguë de padded_size valeurs
+
+void Particle_mesh::transform_line(std::complex<double> *line, bool inverse) const {
+	const std::size_t n = padded_size;
+
+	// Permutation par inversion des bits
+	for (std::size_t i = 1, j = 0; i < n; ++i) {
+		std::size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+
+		if (i < j)
+			std::swap(line[i], line[j]);
+	}
+
+	for (std::size_t length = 2; length <= n; length <<= 1) {
+		const std::size_t half = length / 2, stride = n / length;
+
+		for (std::size_t start = 0; start < n; start += length)
+			for (std::size_t k = 0; k < half; ++k) {
+				const auto twiddle = inverse ? std::conj(twiddles[k * stride]) : twiddles[k * stride];
+				const auto u = line[start + k];
+				const auto v = line[start + k + half] * twiddle;
+				line[start + k] = u + v;
+				line[start + k + half] = u - v;
+			}
+	}
+}
+
+
+
+// FFT 3D de la grille (non normalisée), une ligne après l'autre sur chaque axe
+
+void Particle_mesh::transform(bool inverse, std::size_t extent, const Compute &compute) {
+#ifdef GALAXY_FFTW
+	(void)extent;
+	(void)compute;
+	fftw_execute(static_cast<fftw_plan>(inverse ? backward_plan : forward_plan));
+#else
+	const std::size_t n = padded_size;
+	const std::array<std::size_t, 3> strides = { n * n, n, 1 };
+
+	// Seul le coin extent^3 est non nul à l'aller (ou utile au retour) : sur chaque axe, on ignore les lignes qui coupent
+	// un axe pas encore transformé (ou déjà revenu) au-delà de extent. Ordre des axes : z, y, x à l'aller, l'inverse au retour.
+	for (int pass = 0; pass < 3; ++pass) {
+		const int axis = inverse ? pass : 2 - pass;
+		const int first_axis = axis == 0 ? 1 : 0, second_axis = axis == 2 ? 1 : 2;
+		const std::size_t first_count = first_axis < axis ? extent : n, second_count = second_axis < axis ? extent : n;
+		const std::size_t outer = strides[first_axis], inner = strides[second_axis], stride = strides[axis];
+
+		compute.for_ranges(first_count * second_count, [this, n, second_count, outer, inner, stride, inverse](std::size_t, std::size_t begin, std::size_t end) {
+			std::vector<std::complex<double>> line(n); // Copie contiguë : les lignes selon x sont très espacées en mémoire
+
+			for (std::size_t l = begin; l < end; ++l) {
+				auto *first = grid.data() + (l / second_count) * outer + (l % second_count) * inner;
+
+				for (std::size_t i = 0; i < n; ++i)
+					line[i] = first[i * stride];
+
+				transform_line(line.data(), inverse);
+
+				for (std::size_t i = 0; i < n; ++i)
+					first[i * stride] = line[i];
+			}
+		});
+	}
+#endif
+}
+
+
+
+// Dépose la masse des étoiles sur la grille (CIC), une grille partielle par intervalle
+
+void Particle_mesh::deposit(const Star::range &stars, const Compute &compute) {
+	const std::size_t cells = grid_size * grid_size * grid_size;
+	const auto count = static_cast<std::size_t>(std::distance(stars.begin, stars.end));
+	std::vector<std::vector<double>> partial(compute.chunks(count));
+
+	compute.for_ranges(count, [this, &stars, &partial, cells](std::size_t chunk, std::size_t begin, std::size_t end) {
+		auto &local = partial[chunk];
+		local.assign(cells, 0.);
+
+		for (auto it = stars.begin + begin; it != stars.begin + end; ++it) {
+			std::array<std::size_t, 3> node{};
+			glm::dvec3 f;
+			locate(it->position, node, f);
+			const auto [i, j, k] = node;
+
+			for (int corner = 0; corner < 8; ++corner) {
+				const int di = corner >> 2, dj = (corner >> 1) & 1, dk = corner & 1;
+				const double weight = (di ? f.x : 1. - f.x) * (dj ? f.y : 1. - f.y) * (dk ? f.z : 1. - f.z);
+				local[grid_index(i + di, j + dj, k + dk)] += weight * it->mass;
+			}
+		}
+	});
+
+	masses.assign(cells, 0.);
+	compute.for_ranges(cells, [this, &partial](std::size_t, std::size_t begin, std::size_t end) {
+		for (const auto &local : partial)
+			for (std::size_t c = begin; c < end; ++c)
+				masses[c] += local[c];
+	});
+}
+
+
+
+// Accélération aux noeuds utilisés par l'interpolation : différences finies d'ordre 4 du potentiel
+
+void Particle_mesh::differentiate(const Compute &compute) {
+	const double volume = static_cast<double>(padded_size * padded_size * padded_size);
+	const double scale = -G / (cell_size * cell_size * volume); // Potentiel = G / h * convolution, normalisation de la FFT inverse
+	field.assign(grid_size * grid_size * grid_size, glm::dvec3(0.));
+
+	compute.for_ranges(grid_size - 4, [this, scale](std::size_t, std::size_t begin, std::size_t end) {
+		const auto potential = [this](std::size_t i, std::size_t j, std::size_t k) {
+			return grid[padded_index(i, j, k)].real();
+		};
+
+		for (std::size_t i = begin + 2; i < end + 2; ++i)
+			for (std::size_t j = 2; j + 2 < grid_size; ++j)
+				for (std::size_t k = 2; k + 2 < grid_size; ++k) {
+					const glm::dvec3 gradient = {
+							(2. / 3.) * (potential(i + 1, j, k) - potential(i - 1, j, k)) - (1. / 12.) * (potential(i + 2, j, k) - potential(i - 2, j, k)),
+							(2. / 3.) * (potential(i, j + 1, k) - potential(i, j - 1, k)) - (1. / 12.) * (potential(i, j + 2, k) - potential(i, j - 2, k)),
+							(2. / 3.) * (potential(i, j, k + 1) - potential(i, j, k - 1)) - (1. / 12.) * (potential(i, j, k + 2) - potential(i, j, k - 2))
+					};
+					field[grid_index(i, j, k)] = gradient * scale;
+				}
+	});
+}
+
+
+
+// Calcule le champ longue portée
+
+void Particle_mesh::solve(const Block &root, const Star::range &stars, const Compute &compute) {
+	if (grid_size == 0 || root.nb_stars == 0)
+		return;
+
+	// Boucles sur des lignes ou des plans de la grille : peu d'éléments, mais lourds, découpés même sous le grain
+	Compute rows = compute;
+	rows.grain = 1;
+
+	// La fonction de Green ne dépend que des indices : calculée une seule fois, la taille de cellule n'est qu'un facteur
+	if (green.empty()) {
+		const std::size_t n = padded_size;
+		const double s = split_cells;
+
+		rows.for_ranges(n, [this, n, s](std::size_t, std::size_t begin, std::size_t end) {
+			for (std::size_t i = begin; i < end; ++i)
+				for (std::size_t j = 0; j < n; ++j)
+					for (std::size_t k = 0; k < n; ++k) {
+						// Plus proche image : la grille complétée de zéros rend la convolution circulaire équivalente
+						const glm::dvec3 d = { static_cast<double>(std::min(i, n - i)), static_cast<double>(std::min(j, n - j)), static_cast<double>(std::min(k, n - k)) };
+						const double r = glm::length(d);
+						grid[padded_index(i, j, k)] = r > 0. ? -std::erf(r / (2. * s)) / r : -1. / (s * std::sqrt(PI));
+					}
+		});
+
+		transform(false, padded_size, rows);
+		green = grid;
+	}
+
+	// 10 % de marge : l'arbre n'est reconstruit qu'au début du pas, les étoiles dérivent pendant les sous-pas
+	const double side = root.size * 1.1;
+	cell_size = side / static_cast<double>(grid_size - 5);
+	origin = root.position - glm::dvec3(side * 0.5 + 2. * cell_size);
+
+	deposit(stars, compute);
+
+	rows.for_ranges(padded_size, [this](std::size_t, std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i)
+			for (std::size_t j = 0; j < padded_size; ++j)
+				for (std::size_t k = 0; k < padded_size; ++k)
+					grid[padded_index(i, j, k)] = (i < grid_size && j < grid_size && k < grid_size) ? masses[grid_index(i, j, k)] : 0.;
+	});
+
+	transform(false, grid_size, rows);
+
+	compute.for_ranges(grid.size(), [this](std::size_t, std::size_t begin, std::size_t end) {
+		for (std::size_t c = begin; c < end; ++c)
+			grid[c] *= green[c];
+	});
+
+	transform(true, grid_size, rows);
+	differentiate(rows);
+}
+
+
+
+// Interpole l'accélération longue portée (mêmes poids que le dépôt : pas d'auto-force)
+
+glm::dvec3 Particle_mesh::acceleration(const glm::dvec3 &position) const {
+	if (field.empty())
+		return { 0., 0., 0. };
+
+	std::array<std::size_t, 3> node{};
+	glm::dvec3 f;
+	locate(position, node, f);
+	const auto [i, j, k] = node;
+	glm::dvec3 result(0.);
+
+	for (int corner = 0; corner < 8; ++corner) {
+		const int di = corner >> 2, dj = (corner >> 1) & 1, dk = corner & 1;
+		const double weight = (di ? f.x : 1. - f.x) * (dj ? f.y : 1. - f.y) * (dk ? f.z : 1. - f.z);
+		result += field[grid_index(i + di, j + dj, k + dk)] * weight;
+	}
+
+	return result;
+}
+
+
+
+// Donne le rayon de séparation en mètres
+
+double Particle_mesh::get_split_radius() const {
+	return split_cells * cell_size;
+}
+
+
+
+// Facteur courte portée de la force newtonienne
+
+double short_range_factor(const double &distance, const double &split_radius) {
+	const double x = distance / (2. * split_radius);
+	return std::erfc(x) + (2. / std::sqrt(PI)) * x * std::exp(-x * x);
+}
@@ -0,0 +1,115 @@
+#include "potential.h"
+#include "utils.h"
+
+// Accélération due à un potentiel analytique
+
+glm::dvec3 External_potential::acceleration(const glm::dvec3 &position) const {
+	const auto offset = position - center;
+	const double r2 = glm::dot(offset, offset);
+
+	switch (profile) {
+		case nfw_halo: {
+			if (r2 == 0.)
+				return { 0., 0., 0. };
+
+			const double r = std::sqrt(r2), x = r / scale;
+			const double enclosed = mass * (std::log1p(x) - x / (1. + x));
+			return offset * (-G * enclosed / (r2 * r));
+		}
+
+		case hernquist_halo: {
+			const double r = std::sqrt(r2);
+			if (r == 0.)
+				return { 0., 0., 0. };
+
+			return offset * (-G * mass / (r * (r + scale) * (r + scale)));
+		}
+
+		case logarithmic_halo: {
+			const double q2 = flattening * flattening;
+			const double denominator = scale * scale + offset.x * offset.x + offset.y * offset.y + offset.z * offset.z / q2;
+			return glm::dvec3(offset.x, offset.y, offset.z / q2) * (-speed * speed / denominator);
+		}
+
+		case miyamoto_nagai_disk: {
+			const double zb = std::sqrt(offset.z * offset.z + height * height);
+			const double azb = scale + zb;
+			const double d2 = offset.x * offset.x + offset.y * offset.y + azb * azb;
+			const double factor = -G * mass / (d2 * std::sqrt(d2));
+			// Limite de Kuzmin (height nul) : une étoile du plan n'a pas d'accélération verticale
+			return { offset.x * factor, offset.y * factor, offset.z * factor * (zb > 0. ? azb / zb : 0.) };
+		}
+	}
+
+	return { 0., 0., 0. };
+}
+
+
+
+// Potentiel d'un profil analytique
+
+double External_potential::potential(const glm::dvec3 &position) const {
+	const auto offset = position - center;
+	const double r = glm::length(offset);
+
+	switch (profile) {
+		case nfw_halo:
+			return r > 0. ? -G * mass * std::log1p(r / scale) / r : -G * mass / scale;
+
+		case hernquist_halo:
+			return -G * mass / (r + scale);
+
+		case logarithmic_halo:
+			return 0.5 * speed * speed * std::log(scale * scale + offset.x * offset.x + offset.y * offset.y
+												  + offset.z * offset.z / (flattening * flattening));
+
+		case miyamoto_nagai_disk: {
+			const double azb = scale + std::sqrt(offset.z * offset.z + height * height);
+			return -G * mass / std::sqrt(offset.x * offset.x + offset.y * offset.y + azb * azb);
+		}
+	}
+
+	return 0.;
+}
+
+
+
+// Construit un champ à partir de ses composantes
+
+External_field::External_field(const std::vector<External_potential> &components) {
+	this->components = components;
+}
+
+
+
+// Indique si le champ est nul
+
+bool External_field::empty() const {
+	return components.empty();
+}
+
+
+
+// Accélération totale
+
+glm::dvec3 External_field::acceleration(const glm::dvec3 &position) const {
+	glm::dvec3 result(0.);
+
+	for (const auto &component : components)
+		result += component.acceleration(position);
+
+	return result;
+}
+
+
+
+// Potentiel total
+
+double External_field::potential(const glm::dvec3 &position) const {
+	double result = 0.;
+
+	for (const auto &component : components)
+		result += component.potential(position);
+
+	return result;
+}
@@ -0,0 +1,161 @@
+#include "query.h"
+
+// Distance au carré entre un point et le cube d'un bloc (nulle à l'intérieur)
+
+static double box_distance2(const Block &block, const glm::dvec3 &position) {
+	double distance2 = 0.;
+
+	for (int axis = 0; axis < 3; ++axis) {
+		const double outside = std::max(std::abs(position[axis] - block.position[axis]) - block.size * 0.5, 0.);
+		distance2 += outside * outside;
+	}
+
+	return distance2;
+}
+
+
+
+// Parcours de stars_in_radius
+
+static void radius_search(const Block &block, const glm::dvec3 &center, const double &radius2, std::vector<Neighbour> &result) {
+	if (block.nb_stars == 1) {
+		const Star &star = *std::get<0>(block.contains);
+		const auto offset = star.position - center;
+		const double distance2 = glm::dot(offset, offset);
+
+		if (distance2 <= radius2)
+			result.push_back({ distance2, &star });
+		return;
+	}
+
+	for (const auto &child : std::get<1>(block.contains))
+		if (child.nb_stars > 0 && box_distance2(child, center) <= radius2)
+			radius_search(child, center, radius2, result);
+}
+
+
+
+// Parcours de nearest_stars (tas max : le plus lointain gardé est en tête)
+
+static void nearest_search(const Block &block, const glm::dvec3 &position, std::size_t k, std::vector<Neighbour> &heap) {
+	if (block.nb_stars == 1) {
+		const Star &star = *std::get<0>(block.contains);
+		const auto offset = star.position - position;
+		const double distance2 = glm::dot(offset, offset);
+
+		if (heap.size() < k) {
+			heap.push_back({ distance2, &star });
+			std::push_heap(heap.begin(), heap.end());
+		} else if (distance2 < heap.front().distance2) {
+			std::pop_heap(heap.begin(), heap.end());
+			heap.back() = { distance2, &star };
+			std::push_heap(heap.begin(), heap.end());
+		}
+		return;
+	}
+
+	// Enfants visités du plus proche au plus lointain : le tas se remplit vite de bons candidats et élague le reste
+	std::array<std::pair<double, const Block *>, 8> order;
+	std::size_t count = 0;
+
+	for (const auto &child : std::get<1>(block.contains))
+		if (child.nb_stars > 0)
+			order[count++] = { box_distance2(child, position), &child };
+
+	std::sort(order.begin(), order.begin() + count, [](const auto &a, const auto &b) { return a.first < b.first; });
+
+	for (std::size_t i = 0; i < count; ++i) {
+		if (heap.size() == k && order[i].first >= heap.front().distance2)
+			break;
+
+		nearest_search(*order[i].second, position, k, heap);
+	}
+}
+
+
+
+// Parcours de stars_in_box
+
+static void box_search(const Block &block, const Bounding_box &box, std::vector<const Star *> &result) {
+	if (block.nb_stars == 1) {
+		const Star &star = *std::get<0>(block.contains);
+
+		if (star.position.x >= box.min.x && star.position.x <= box.max.x
+			&& star.position.y >= box.min.y && star.position.y <= box.max.y
+			&& star.position.z >= box.min.z && star.position.z <= box.max.z)
+			result.push_back(&star);
+		return;
+	}
+
+	for (const auto &child : std::get<1>(block.contains)) {
+		if (child.nb_stars == 0)
+			continue;
+
+		bool overlaps = true;
+		for (int axis = 0; axis < 3; ++axis)
+			overlaps = overlaps && child.position[axis] - child.size * 0.5 <= box.max[axis] && child.position[axis] + child.size * 0.5 >= box.min[axis];
+
+		if (overlaps)
+			box_search(child, box, result);
+	}
+}
+
+
+
+// Étoiles à moins de radius d'un point
+
+void stars_in_radius(const Block &root, const glm::dvec3 &center, const double &radius, std::vector<Neighbour> &result) {
+	if (root.nb_stars > 0)
+		radius_search(root, center, radius * radius, result);
+}
+
+
+
+// k plus proches étoiles d'un point
+
+void nearest_stars(const Block &root, const glm::dvec3 &position, std::size_t k, std::vector<Neighbour> &result) {
+	result.clear();
+
+	if (root.nb_stars == 0 || k == 0)
+		return;
+
+	nearest_search(root, position, k, result);
+	std::sort_heap(result.begin(), result.end());
+}
+
+
+
+// Étoiles contenues dans une boîte
+
+void stars_in_box(const Block &root, const Bounding_box &box, std::vector<const Star *> &result) {
+	if (root.nb_stars > 0 && !box.is_empty())
+		box_search(root, box, result);
+}
+
+
+
+// Lance stars_in_radius pour plusieurs points (une tâche par point : leurs coûts varient beaucoup avec la densité locale)
+
+std::vector<std::vector<Neighbour>> stars_in_radius(const Block &root, const std::vector<glm::dvec3> &centers, const double &radius, const Compute &compute) {
+	std::vector<std::vector<Neighbour>> results(centers.size());
+
+	compute.tasks(centers.size(), [&root, &centers, &radius, &results](std::size_t i) {
+		stars_in_radius(root, centers[i], radius, results[i]);
+	});
+
+	return results;
+}
+
+
+
+// Lance nearest_stars pour plusieurs points (une tâche par point)
+
+std::vector<std::vector<Neighbour>> nearest_stars(const Block &root, const std::vector<glm::dvec3> &positions, std::size_t k, const Compute &compute) {
+	std::vector<std::vector<Neighbour>> results(positions.size());
+
+	compute.tasks(positions.size(), [&root, &positions, k, &results](std::size_t i) {
+		nearest_stars(root, positions[i], k, results[i]);
+	});
+
+	return results;
+}
@@ -0,0 +1,149 @@
+#include "render.h"
+
+SDL_Window *window = nullptr;
+
+SDL_Renderer *renderer = nullptr;
+
+
+
+// Copie les étoiles vivantes dans le snapshot
+
+void Snapshot::capture(const Star::range &alive_galaxy, const glm::dvec3 &mass_center, const std::vector<double> *densities,
+					   const Compute &compute) {
+	const auto count = static_cast<std::size_t>(std::distance(alive_galaxy.begin, alive_galaxy.end));
+
+	positions.resize(count);
+	this->densities.resize(count);
+	colors.resize(count);
+
+	compute.for_ranges(count, [this, &alive_galaxy, densities](std::size_t, std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i) {
+			const auto &star = alive_galaxy.begin[i];
+			positions[i] = star.position;
+			this->densities[i] = densities ? (*densities)[star.index] : star.density;
+			colors[i] = star.color;
+		}
+	});
+
+	this->mass_center = mass_center;
+}
+
+
+
+// Boucle du thread de rendu
+
+void render_loop(Triple_buffer<Snapshot> &snapshots, const Palette *palette, std::atomic<bool> &quit,
+				 const double &area, const double &zoom, View view) {
+	using namespace std::chrono_literals;
+
+	// La fenêtre est créée par ce thread : SDL impose de traiter ses évènements depuis le même thread.
+	SDL_Init(SDL_INIT_VIDEO);
+	SDL_CreateWindowAndRenderer(WIDTH, HEIGHT, 0, &window, &renderer);
+	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+	SDL_SetWindowTitle(window, "Galaxy simulation");
+	SDL_Event event;
+	std::vector<glm::u8vec3> mapped_colors;
+
+	while (!quit) {
+		while (SDL_PollEvent(&event) != 0) {
+			if (event.type == SDL_QUIT || (event.type == SDL_KEYDOWN || event.key.keysym.scancode == SDL_SCANCODE_ESCAPE))
+				quit = true;
+		}
+
+		if (!snapshots.update()) { // Pas de nouvel état : on n'attend pas le calcul, on revient simplement aux évènements
+			std::this_thread::sleep_for(1ms);
+			continue;
+		}
+
+		const Snapshot &snapshot = snapshots.front();
+
+		// Dans ce thread seulement : passer par le pool du calcul ferait attendre l'un derrière l'autre
+		if (palette)
+			palette->apply(snapshot.densities, mapped_colors);
+
+		SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
+		SDL_RenderClear(renderer);
+
+		draw_stars(snapshot, palette ? mapped_colors : snapshot.colors, area, zoom, view);
+
+		SDL_RenderPresent(renderer);
+		SDL_GL_SwapWindow(window);
+	}
+
+	if (renderer)
+		SDL_DestroyRenderer(renderer);
+
+	if (window)
+		SDL_DestroyWindow(window);
+
+	SDL_Quit();
+}
+
+
+
+// Affiche les étoiles d'un snapshot
+
+void draw_stars(const Snapshot &snapshot, const std::vector<glm::u8vec3> &colors, const double &area, const double &zoom, View view) {
+	double x, y, z;
+//	Vector screen_position;
+	const double coef = 1. / (area / zoom);
+
+	for (std::size_t i = 0; i < snapshot.positions.size(); ++i) {
+		const auto &position = snapshot.positions[i];
+		const auto &color = colors[i];
+		const auto tmp = position - snapshot.mass_center;
+		switch (view) {
+			case default_view: { // Portée obligatoire : initialisation d'une variable à l'intérieur d'un case.
+				x = tmp.x;
+				y = tmp.y / 3. - tmp.z / 1.5;
+
+				const glm::dvec3 camera(0., area * 0.5, area * 0.5);
+				const auto screen_position = create_spherical(glm::length(glm::dvec3{ x, y, 0. }) / glm::distance(position, camera),
+															  glm::get_phi(glm::dvec3{ x, y, 0. }),
+															  glm::get_theta(glm::dvec3{ x, y, 0. }));
+
+				x = screen_position.x * zoom + WIDTH * 0.5;
+				y = screen_position.y * zoom + HEIGHT * 0.5;
+			}
+				break;
+
+			case xy:
+
+				x = tmp.x * coef + WIDTH * 0.5;
+				y = tmp.y * coef + HEIGHT * 0.5;
+				break;
+
+			case xz:
+
+				x = tmp.x * coef + WIDTH * 0.5;
+				y = tmp.z * coef + HEIGHT * 0.5;
+				break;
+
+			case yz:
+
+				x = tmp.y * coef + WIDTH * 0.5;
+				y = tmp.z * coef + HEIGHT * 0.5;
+				break;
+		}
+		{
+			const int x_sdl = static_cast<int>(x), y_sdl = static_cast<int>(y);
+			SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, SDL_ALPHA_OPAQUE);
+
+			SDL_RenderDrawPoint(renderer, x_sdl, y_sdl);
+
+			SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, SDL_ALPHA_OPAQUE * 0.5);
+
+			SDL_RenderDrawPoint(renderer, x_sdl - 1, y_sdl);
+			SDL_RenderDrawPoint(renderer, x_sdl, y_sdl - 1);
+			SDL_RenderDrawPoint(renderer, x_sdl, y_sdl + 1);
+			SDL_RenderDrawPoint(renderer, x_sdl + 1, y_sdl);
+
+			SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, SDL_ALPHA_OPAQUE * 0.25);
+
+			SDL_RenderDrawPoint(renderer, x_sdl - 1, y_sdl - 1);
+			SDL_RenderDrawPoint(renderer, x_sdl - 1, y_sdl + 1);
+			SDL_RenderDrawPoint(renderer, x_sdl + 1, y_sdl - 1);
+			SDL_RenderDrawPoint(renderer, x_sdl + 1, y_sdl + 1);
+		}
+	}
+}
\ No newline at end of file
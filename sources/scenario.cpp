@@ -0,0 +1,321 @@
+#include "scenario.h"
+#include "utils.h"
+#include "softening.h"
+
+struct Mass_class {
+	double fraction;   // Proportion des étoiles générées
+	double min_mass;   // En masses solaires
+	double max_mass;
+	glm::u8vec3 color;
+};
+
+// Classes de masse des étoiles générées, de la naine rouge à l'étoile bleue
+static const std::array<Mass_class, 6> mass_classes = { {
+	{ 0.764, 0.08, 0.45, { 255, 10, 10 } },
+	{ 0.121, 0.45, 0.8, { 255, 127, 10 } },
+	{ 0.076, 0.8, 1.04, { 255, 255, 10 } },
+	{ 0.030, 1.04, 1.4, { 255, 255, 127 } },
+	{ 0.006, 1.4, 2.1, { 255, 255, 255 } },
+	{ 0.0013, 2.1, 16., { 50, 255, 255 } }
+} };
+
+constexpr int black_hole_class = -1;
+constexpr int loaded_class = -2;
+
+// Étoiles consécutives du conteneur créées de la même façon
+struct Segment {
+	std::size_t begin;
+	std::size_t end;
+	const Galaxy_model *model;
+	int mass_class;                    // Indice dans mass_classes, black_hole_class ou loaded_class
+	const Star::container *loaded;     // Étoiles lues (loaded_class)
+};
+
+// Masse intérieure d'une galaxie en fonction du rayon
+struct Mass_profile {
+	static constexpr std::size_t nb_bins = 256;
+
+	double width{ 0. };                 // Largeur d'une couronne
+	double central{ 0. };               // Masse au centre exact (trou noir)
+	std::vector<double> masses;         // Masse de chaque couronne
+	std::vector<double> enclosed;       // Masse intérieure au bord intérieur de chaque couronne
+};
+
+// Tourne un vecteur du repère de la galaxie vers celui de la simulation
+
+static glm::dvec3 orient(const glm::dvec3 &vector, const Galaxy_model &model) {
+	const double ci = std::cos(model.inclination), si = std::sin(model.inclination);
+	const double cn = std::cos(model.node), sn = std::sin(model.node);
+	const glm::dvec3 tilted(vector.x, vector.y * ci - vector.z * si, vector.y * si + vector.z * ci);
+
+	return { tilted.x * cn - tilted.y * sn, tilted.x * sn + tilted.y * cn, tilted.z };
+}
+
+
+
+// Crée une étoile du segment (les étoiles générées reprennent la distribution de l'ancienne galaxie unique)
+
+static Star create_star(const Segment &segment, std::size_t i, std::mt19937_64 &generator) {
+	std::uniform_real_distribution<double> uniform(0., 1.);
+	const Galaxy_model &model = *segment.model;
+	Star star;
+
+	if (segment.mass_class == loaded_class)
+		star = (*segment.loaded)[i - segment.begin];
+
+	else if (segment.mass_class == black_hole_class) {
+		star.mass = model.black_hole_mass * SOLAR_MASS;
+		star.color = { 0, 0, 0 };
+	}
+
+	else {
+		const Mass_class &mass_class = mass_classes[segment.mass_class];
+		star.position = create_spherical((std::sqrt(uniform(generator)) - 0.5) * model.area, uniform(generator) * 2. * PI, PI * 0.5);
+		star.position.z = (uniform(generator) - 0.5) * (model.area * model.thickness);
+
+		const double radius = std::sqrt(star.position.x * star.position.x + star.position.y * star.position.y);
+		if (radius > 0.)
+			star.speed = glm::dvec3(-star.position.y, star.position.x, 0.) * (model.initial_speed / radius); // Rotation dans le sens direct
+
+		star.mass = (mass_class.min_mass + uniform(generator) * (mass_class.max_mass - mass_class.min_mass)) * SOLAR_MASS;
+		star.color = mass_class.color;
+	}
+
+	star.position = model.position + orient(star.position, model);
+	star.speed = model.speed + orient(star.speed, model);
+	star.is_alive = true;
+	star.index = i;
+
+	return star;
+}
+
+
+
+// Parcourt les étoiles par paquets de taille fixe (une tâche du backend de calcul par paquet), chaque paquet tire dans son
+// propre générateur
+
+static void for_each_chunk(std::size_t total, std::uint64_t seed, std::uint32_t pass, const Compute &compute,
+						   const std::function<void(std::size_t, std::size_t, std::mt19937_64 &)> &process) {
+	constexpr std::size_t chunk_size = 4096;
+	const std::size_t nb_chunks = (total + chunk_size - 1) / chunk_size;
+
+	compute.tasks(nb_chunks, [&process, total, seed, pass](std::size_t chunk) {
+		std::seed_seq sequence{ static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32), pass, static_cast<std::uint32_t>(chunk) };
+		std::mt19937_64 generator(sequence);
+
+		process(chunk * chunk_size, std::min(total, (chunk + 1) * chunk_size), generator);
+	});
+}
+
+
+
+// Construit l'histogramme radial des masses des étoiles [begin, end) autour d'un centre
+
+static Mass_profile mass_profile(const Star::container &galaxy, std::size_t begin, std::size_t end, const glm::dvec3 &center) {
+	Mass_profile profile;
+	double max_radius = 0.;
+
+	for (std::size_t i = begin; i < end; ++i)
+		max_radius = std::max(max_radius, glm::distance(galaxy[i].position, center));
+
+	profile.width = max_radius / Mass_profile::nb_bins;
+	profile.masses.assign(Mass_profile::nb_bins, 0.);
+	profile.enclosed.assign(Mass_profile::nb_bins, 0.);
+
+	for (std::size_t i = begin; i < end; ++i) {
+		const double radius = glm::distance(galaxy[i].position, center);
+
+		if (radius == 0.)
+			profile.central += galaxy[i].mass;
+		else
+			profile.masses[std::min(static_cast<std::size_t>(radius / profile.width), Mass_profile::nb_bins - 1)] += galaxy[i].mass;
+	}
+
+	for (std::size_t k = 1; k < Mass_profile::nb_bins; ++k)
+		profile.enclosed[k] = profile.enclosed[k - 1] + profile.masses[k - 1];
+
+	return profile;
+}
+
+
+
+// Donne la masse intérieure à un rayon (répartition uniforme dans chaque couronne)
+
+static double enclosed_mass(const Mass_profile &profile, const double &radius) {
+	if (profile.width == 0.)
+		return profile.central;
+
+	const double position = radius / profile.width;
+	const auto k = std::min(static_cast<std::size_t>(position), Mass_profile::nb_bins - 1);
+
+	return profile.central + profile.enclosed[k] + profile.masses[k] * std::min(position - k, 1.);
+}
+
+
+
+// Donne à une étoile la vitesse circulaire de son orbite, plus une dispersion aléatoire
+
+static void set_circular_speed(Star &star, const Galaxy_model &model, const Mass_profile &profile, const External_field *external,
+							   std::mt19937_64 &generator) {
+	const glm::dvec3 axis = orient({ 0., 0., 1. }, model);
+	const auto offset = star.position - model.position;
+	const auto in_plane = offset - axis * glm::dot(offset, axis);
+	const double radius2 = glm::dot(offset, offset);
+	const double cylindrical2 = glm::dot(in_plane, in_plane);
+
+	star.speed = model.speed;
+
+	if (cylindrical2 == 0.)
+		return;
+
+	double speed2 = G * enclosed_mass(profile, std::sqrt(radius2)) * cylindrical2 * Softening::force(radius2, SOFTENING_LENGTH);
+
+	if (external && !external->empty())
+		speed2 += std::max(-glm::dot(external->acceleration(star.position), in_plane), 0.);
+
+	const double circular_speed = std::sqrt(speed2);
+	star.speed += glm::cross(axis, in_plane) * (circular_speed / std::sqrt(cylindrical2));
+
+	if (model.dispersion > 0.) {
+		std::normal_distribution<double> normal(0., model.dispersion * circular_speed);
+		star.speed += glm::dvec3(normal(generator), normal(generator), normal(generator));
+	}
+}
+
+
+
+// Crée les étoiles de toutes les galaxies d'un scénario
+
+bool create_scenario(Star::container &galaxy, const std::vector<Galaxy_model> &models, std::uint64_t seed, const Compute &compute,
+					 const External_field *external) {
+	std::list<Star::container> loaded; // Adresses stables pour les segments
+	std::vector<Segment> segments;
+	std::size_t total = 0;
+
+	const auto add_segment = [&segments, &total](std::size_t count, const Galaxy_model &model, int mass_class, const Star::container *stars) {
+		if (count > 0)
+			segments.push_back({ total, total + count, &model, mass_class, stars });
+		total += count;
+	};
+
+	for (const auto &model : models) {
+		if (!model.file.empty()) {
+			loaded.emplace_back();
+			if (!load_initial_conditions(model.file, loaded.back()))
+				return false;
+
+			add_segment(loaded.back().size(), model, loaded_class, &loaded.back());
+			continue;
+		}
+
+		for (int c = 0; c < static_cast<int>(mass_classes.size()); ++c)
+			add_segment(static_cast<std::size_t>(model.stars_number * mass_classes[c].fraction) + 1, model, c, nullptr);
+
+		if (model.is_black_hole)
+			add_segment(1, model, black_hole_class, nullptr);
+	}
+
+	galaxy.clear();
+	galaxy.resize(total);
+	galaxy.shrink_to_fit();
+
+	const auto segment_of = [&segments](std::size_t i) {
+		return std::prev(std::upper_bound(segments.begin(), segments.end(), i, [](std::size_t i, const Segment &s) { return i < s.begin; }));
+	};
+
+	for_each_chunk(total, seed, 0, compute, [&galaxy, &segment_of](std::size_t begin, std::size_t end, std::mt19937_64 &generator) {
+		auto segment = segment_of(begin);
+
+		for (std::size_t i = begin; i < end; ++i) {
+			while (i >= segment->end)
+				++segment;
+
+			galaxy[i] = create_star(*segment, i, generator);
+		}
+	});
+
+	// Les vitesses d'équilibre dépendent de la masse de toute la galaxie : seconde passe, une fois toutes les étoiles placées
+	std::vector<Mass_profile> profiles(models.size());
+	bool has_equilibrium = false;
+
+	for (std::size_t m = 0; m < models.size(); ++m) {
+		if (!models[m].equilibrium || !models[m].file.empty())
+			continue;
+
+		std::size_t begin = total, end = 0; // Les segments d'une galaxie sont consécutifs
+		for (const auto &segment : segments)
+			if (segment.model == &models[m]) {
+				begin = std::min(begin, segment.begin);
+				end = std::max(end, segment.end);
+			}
+
+		if (begin < end) {
+			profiles[m] = mass_profile(galaxy, begin, end, models[m].position);
+			has_equilibrium = true;
+		}
+	}
+
+	if (has_equilibrium)
+		for_each_chunk(total, seed, 1, compute, [&galaxy, &segment_of, &models, &profiles, external](std::size_t begin, std::size_t end, std::mt19937_64 &generator) {
+			auto segment = segment_of(begin);
+
+			for (std::size_t i = begin; i < end; ++i) {
+				while (i >= segment->end)
+					++segment;
+
+				const Galaxy_model &model = *segment->model;
+				if (model.equilibrium && segment->mass_class != loaded_class)
+					set_circular_speed(galaxy[i], model, profiles[segment->model - models.data()], external, generator);
+			}
+		});
+
+	return true;
+}
+
+
+
+// Lit des conditions initiales
+
+bool load_initial_conditions(const std::string &path, Star::container &stars) {
+	std::ifstream file(path);
+
+	if (!file) {
+		std::cerr << "Impossible d'ouvrir le fichier de conditions initiales " << path << std::endl;
+		return false;
+	}
+
+	std::string line;
+	std::size_t line_number = 0;
+
+	while (std::getline(file, line)) {
+		++line_number;
+		const auto first = line.find_first_not_of(" \t\r");
+
+		if (first == std::string::npos || line[first] == '#')
+			continue;
+
+		std::istringstream stream(line);
+		Star star;
+		double mass;
+
+		if (!(stream >> star.position.x >> star.position.y >> star.position.z >> star.speed.x >> star.speed.y >> star.speed.z >> mass) || mass <= 0.) {
+			std::cerr << path << ":" << line_number << " : ligne invalide (attendu : x y z vx vy vz masse)" << std::endl;
+			return false;
+		}
+
+		star.position *= LIGHT_YEAR;
+		star.mass = mass * SOLAR_MASS;
+
+		// Couleur de la classe de masse correspondante (couleurs réelles)
+		star.color = mass_classes.back().color;
+		for (const auto &mass_class : mass_classes)
+			if (mass <= mass_class.max_mass) {
+				star.color = mass_class.color;
+				break;
+			}
+
+		stars.push_back(star);
+	}
+
+	return true;
+}
@@ -1,42 +1,20 @@
 #include "star.h"
 #include "utils.h"
 #include "block.h"
+#include "pm.h"
+#include "softening.h"
 
-// Construit une étoile à des coordonnées aléatoires dans la zone
-
-Star::Star(const double &initial_speed, const double &area, const double &step, const double &galaxy_thickness) {
-	is_alive = true;
-	position = create_spherical((sqrt(random_double(0., 1.)) - 0.5) * area,
-								random_double(0., 2. * PI),
-								PI * 0.5); // Multiplication plus rapide qu'une division.
-	position.z = ((random_double(0., 1.) - 0.5) * (area * galaxy_thickness));
-	speed = create_spherical(initial_speed, glm::get_phi(position) + PI * 0.5, PI * 0.5);
-	previous_position = position - speed * step;
-	acceleration = { 0., 0., 0. };
-	color = { 0, 0, 0 };
-	mass = 0.;
-	density = 0.;
-	index = 0;
-	block_index = 0;
-}
-
-// Met à jour la position
+// Met à jour la position (dérive)
 
-void Star::update_position(const double &step, bool verlet_integration) {
-	if (verlet_integration) {
-		auto temp = position;
-
-		position = 2. * position - previous_position + acceleration * step * step; // Intégration de Verlet
-		previous_position = temp;
-	} else
-		position += speed * step; // Méthode d'Euler
+void Star::update_position(const double &step) {
+	position += speed * step;
 }
 
 
 
-// Met à jour la vitesse
+// Met à jour la vitesse (poussée)
 
-void Star::update_speed(const double &step, const double &area) {
+void Star::update_speed(const double &step) {
 	speed += acceleration * step;
 }
 
@@ -44,134 +22,127 @@ void Star::update_speed(const double &step, const double &area) {
 
 // Met à jour l'accélération et la densité
 
-void Star::update_acceleration_and_density(const double &precision, const Block &block) {
+void Star::update_acceleration_and_density(const double &precision, const Block &block, bool quadrupole, const double &split_radius, std::size_t prefetch_distance,
+										   bool with_density) {
 	density = 0.;
-	double max_acceleration = 0.0000000005; // Permet de limiter l'erreur due au pas de temps (à régler en fonction du pas de temps)
-
-	// Pas de division par la masse de l'étoile (c.f. ligne 122) EDIT : trouver un autre moyen de référence que la ligne de code.
-	acceleration = force_and_density_calculation(precision, *this, block); // Fonction récursive… Il faut éviter.
+	interactions = 0;
 
-	if (glm::length(acceleration) > max_acceleration)
-		acceleration = max_acceleration * normalize(acceleration);
+	// Pas de division par la masse de l'étoile (c.f. force_and_density_calculation)
+	acceleration = force_and_density_calculation(precision, *this, block, quadrupole, split_radius, prefetch_distance, with_density);
 }
 
 
 
-// Calcule la densité et la force exercée sur une étoile (divisée par la masse de l'étoile pour éviter des calculs inutiles)
+// Choisit le niveau de pas de temps à partir de l'accélération (remplace la limitation de l'accélération)
 
-glm::dvec3 force_and_density_calculation(const double &precision, Star &star, const Block &block) {
-	glm::dvec3 force(0); // Tous les champs à 0.
-	const auto star_to_mass = (star.position - block.mass_center);
-	double distance = glm::distance(star.position, block.mass_center);
+void Star::update_rung(const double &step, int max_rung, std::size_t substep, const double &accuracy, const double &length) {
+	const double norm = glm::length(acceleration);
+	int wanted = 0;
 
-	if (block.nb_stars == 1) {
-		Star::container::iterator itStar = std::get<0>(block.contains);
+	if (norm > 0.) {
+		const double wanted_step = std::sqrt(2. * accuracy * length / norm);
+		wanted = static_cast<int>(std::ceil(std::log2(step / wanted_step)));
+		wanted = std::clamp(wanted, 0, max_rung);
+	}
 
-		if (distance != 0.) {
-			double inv_distance = 1. / distance;
-			force += (star_to_mass * inv_distance) * (-(G * block.mass) / (distance * distance));
-			star.density += (inv_distance / LIGHT_YEAR);
-		}
-	} else {
-		double thema = block.size / distance;
+	// Un pas plus grand n'est possible que si le sous-pas courant est aussi une frontière de ce pas
+	while (substep % rung_period(wanted, max_rung) != 0)
+		++wanted;
 
-		if (thema < precision) {
-			force += (star_to_mass / distance) * (-(G * block.mass) / (distance * distance));
-			star.density += block.nb_stars / (distance / LIGHT_YEAR);
-		} else {
-			auto &blocks = std::get<1>(block.contains);
-			for (int i = 0; i < 8; ++i) {
-				if (blocks[i].nb_stars > 0)
-					force += force_and_density_calculation(precision, star, blocks[i]); // WTF ?! PAS DE RÉCURSIF, PERTE DE PERF
-			}
-		}
-	}
+	rung = static_cast<std::uint8_t>(wanted);
+}
 
-	return force;
+
+
+// Donne le nombre de sous-pas (de taille step / 2^max_rung) d'un niveau
+
+std::size_t rung_period(int rung, int max_rung) {
+	return std::size_t{ 1 } << (max_rung - rung);
 }
 
 
 
-// Met à jour la couleur
+// Calcule la densité et la force exercée sur une étoile (divisée par la masse de l'étoile pour éviter des calculs inutiles)
+// Pile explicite plutôt que récursion : les prochains blocs à visiter sont connus, donc demandés au cache à l'avance.
+
+glm::dvec3 force_and_density_calculation(const double &precision, Star &star, const Block &block, bool quadrupole, const double &split_radius, std::size_t prefetch_distance,
+										 bool with_density) {
+	static thread_local std::vector<const Block *> stack; // Réutilisée d'une étoile à l'autre : pas d'allocation par parcours
+	glm::dvec3 force(0); // Tous les champs à 0.
+	stack.clear();
+	stack.push_back(&block);
+
+	while (!stack.empty()) {
+		const Block &node = *stack.back();
+		stack.pop_back();
 
-void Star::update_color() {
-	constexpr int colorT3 = 255 * 3, colorT2 = 255 * 2;
-	int color_nb = static_cast<int>(density * 2.);
+		// Les enfants d'un bloc sont dans un vecteur à part : sans préchargement, chaque visite attend la mémoire
+		if (prefetch_distance > 0 && prefetch_distance <= stack.size())
+			prefetch(*stack[stack.size() - prefetch_distance]);
 
-	if (color_nb > colorT3)
-		color_nb = colorT3;
+		++star.interactions; // Blocs visités, ouverts ou non : coût du parcours pour cette étoile
+		const auto star_to_mass = (star.position - node.mass_center);
+		const double distance = glm::distance(star.position, node.mass_center);
 
-	if (color_nb < 255)
-		color = { 0, 0, color_nb };
+		// TreePM : au-delà de la coupure, le bloc entier n'agit plus qu'à travers la grille (sqrt(3) * size majore l'écart au centre de gravité)
+		if (split_radius > 0. && distance - node.size * 1.7321 > Particle_mesh::cutoff * split_radius)
+			continue;
 
-	else if (color_nb < colorT2)
-		color = { 0, color_nb - 255, 255 };
+		glm::dvec3 node_force(0);
 
-	else
-		color = { color_nb - colorT2, 255, 255 };
-}
+		if (!node.as_children) { // Une étoile, ou une pseudo-étoile de l'arbre des fantômes (nb_stars étoiles)
+			if (distance != 0.) {
+				node_force = star_to_mass * (-(G * node.mass) * Softening::force(distance * distance, SOFTENING_LENGTH));
 
+				if (with_density)
+					star.density += node.nb_stars == 1 ? (1. / distance / LIGHT_YEAR) : node.nb_stars / (distance / LIGHT_YEAR);
+			}
+		} else if (node.size / distance < precision) {
+			node_force = star_to_mass * (-(G * node.mass) * Softening::force(distance * distance, SOFTENING_LENGTH));
 
+			if (with_density)
+				star.density += node.nb_stars / (distance / LIGHT_YEAR);
 
-// Initialise la galaxie
+			if (quadrupole) // Correction d'ordre 2 : même erreur avec un angle d'ouverture plus grand
+				node_force += quadrupole_acceleration(node, star_to_mass, distance);
+		} else {
+			// Empilés du dernier au premier : visités dans l'ordre des enfants
+			const auto &blocks = std::get<1>(node.contains);
+			for (auto child = blocks.rbegin(); child != blocks.rend(); ++child) {
+				if (child->nb_stars > 0)
+					stack.push_back(&*child);
+			}
 
-void initialize_galaxy(Star::container &galaxy,
-					   int stars_number,
-					   const double &area,
-					   const double &initial_speed,
-					   const double &step,
-					   bool is_black_hole,
-					   const double &black_hole_mass,
-					   const double &galaxy_thickness) {
-	for (int i = 0; i <= stars_number * 0.764; ++i) {
-		galaxy.emplace_back(initial_speed, area, step, galaxy_thickness);
-		galaxy.back().mass = random_double(0.08, 0.45) * SOLAR_MASS;
-		galaxy.back().color = { 255, 10, 10 };
-		galaxy.back().index = galaxy.size() - 1;
-	}
+			continue; // Facteur courte portée appliqué à chaque enfant
+		}
 
-	for (int i = 0; i <= stars_number * 0.121; ++i) {
-		galaxy.emplace_back(initial_speed, area, step, galaxy_thickness);
-		galaxy.back().mass = random_double(0.45, 0.8) * SOLAR_MASS;
-		galaxy.back().color = { 255, 127, 10 };
-		galaxy.back().index = galaxy.size() - 1;
-	}
+		if (split_radius > 0.)
+			node_force *= short_range_factor(distance, split_radius);
 
-	for (int i = 0; i <= stars_number * 0.076; ++i) {
-		galaxy.emplace_back(initial_speed, area, step, galaxy_thickness);
-		galaxy.back().mass = random_double(0.8, 1.04) * SOLAR_MASS;
-		galaxy.back().color = { 255, 255, 10 };
-		galaxy.back().index = galaxy.size() - 1;
+		force += node_force;
 	}
 
-	for (int i = 0; i <= stars_number * 0.030; ++i) {
-		galaxy.emplace_back(initial_speed, area, step, galaxy_thickness);
-		galaxy.back().mass = random_double(1.04, 1.4) * SOLAR_MASS;
-		galaxy.back().color = { 255, 255, 127 };
-		galaxy.back().index = galaxy.size() - 1;
-	}
+	return force;
+}
 
-	for (int i = 0; i <= stars_number * 0.006; ++i) {
-		galaxy.emplace_back(initial_speed, area, step, galaxy_thickness);
-		galaxy.back().mass = random_double(1.4, 2.1) * SOLAR_MASS;
-		galaxy.back().color = { 255, 255, 255 };
-		galaxy.back().index = galaxy.size() - 1;
-	}
 
-	for (int i = 0; i <= stars_number * 0.0013; ++i) {
-		galaxy.emplace_back(initial_speed, area, step, galaxy_thickness);
-		galaxy.back().mass = random_double(2.1, 16) * SOLAR_MASS;
-		galaxy.back().color = { 50, 255, 255 };
-		galaxy.back().index = galaxy.size() - 1;
-	}
 
-	if (is_black_hole) {
-		galaxy.emplace_back(initial_speed, area, step, galaxy_thickness);
-		galaxy.back().position = { 0., 0., 0. };
-		galaxy.back().speed = { 0., 0., 0. };
-		galaxy.back().mass = black_hole_mass * SOLAR_MASS;
-		galaxy.back().color = { 0, 0, 0 };
-		galaxy.back().index = galaxy.size() - 1;
+// Retire les étoiles sorties (échange avec la fin de la partie vivante)
+
+void remove_escaped(Star::container &galaxy, Star::range &alive_galaxy, std::vector<std::size_t> &escaped, std::vector<Star::index_type> &slots) {
+	// Ordre décroissant : tout ce qui se trouve après la position traitée est alors vivant, l'échange est toujours valide.
+	std::sort(escaped.begin(), escaped.end(), std::greater<>());
+
+	for (const auto position : escaped) {
+		const auto last = std::prev(alive_galaxy.end);
+		const auto dead = galaxy.begin() + position;
+
+		if (dead != last) {
+			std::swap(*dead, *last);
+			slots[dead->index] = position;
+			slots[last->index] = static_cast<std::size_t>(std::distance(galaxy.begin(), last));
+		}
+
+		alive_galaxy.end = last;
 	}
-	galaxy.shrink_to_fit();
-}
\ No newline at end of file
+}
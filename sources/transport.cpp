@@ -0,0 +1,275 @@
+#include "transport.h"
+#include <cstring>
+#include <cerrno>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Rang du processus unique
+
+std::size_t Local_transport::rank() const {
+	return 0;
+}
+
+
+
+// Nombre de rangs (un seul)
+
+std::size_t Local_transport::size() const {
+	return 1;
+}
+
+
+
+// Le seul message est celui envoyé à soi-même
+
+std::vector<std::vector<char>> Local_transport::exchange(const std::vector<std::vector<char>> &messages) {
+	return messages;
+}
+
+#ifndef _WIN32
+
+// Un rang s'est arrêté au milieu d'un échange : impossible de continuer
+
+[[noreturn]] static void disconnected(std::size_t rank, const char *reason) {
+	std::cerr << "Rang " << rank << " déconnecté (" << reason << ")" << std::endl;
+	std::exit(EXIT_FAILURE);
+}
+
+
+
+// Erreur passagère d'une socket non bloquante : il suffit de recommencer
+
+static bool is_transient(int error) {
+	return error == EAGAIN || error == EWOULDBLOCK || error == EINTR;
+}
+
+
+
+// Construit le transport d'un rang
+
+Socket_transport::Socket_transport(std::size_t rank, std::vector<int> sockets, std::vector<int> children) {
+	this->current_rank = rank;
+	this->sockets = std::move(sockets);
+	this->children = std::move(children);
+
+	for (const int socket : this->sockets)
+		if (socket >= 0)
+			fcntl(socket, F_SETFL, fcntl(socket, F_GETFL) | O_NONBLOCK);
+}
+
+
+
+// Ferme les sockets puis attend la fin des processus fils
+
+Socket_transport::~Socket_transport() {
+	for (const int socket : sockets)
+		if (socket >= 0)
+			close(socket);
+
+	for (const int child : children)
+		waitpid(child, nullptr, 0);
+}
+
+
+
+// Rang du processus
+
+std::size_t Socket_transport::rank() const {
+	return current_rank;
+}
+
+
+
+// Nombre de rangs
+
+std::size_t Socket_transport::size() const {
+	return sockets.size();
+}
+
+
+
+// Échange tout-à-tous : chaque message est précédé de sa taille (8 octets)
+
+std::vector<std::vector<char>> Socket_transport::exchange(const std::vector<std::vector<char>> &messages) {
+	const std::size_t nb_ranks = size();
+	std::vector<std::vector<char>> received(nb_ranks);
+	std::vector<std::vector<char>> outgoing(nb_ranks);
+	std::vector<std::size_t> written(nb_ranks, 0), read(nb_ranks, 0);
+	std::vector<bool> has_header(nb_ranks, false);
+	std::size_t pending = 0;
+
+	received[current_rank] = messages[current_rank];
+
+	for (std::size_t r = 0; r < nb_ranks; ++r) {
+		if (r == current_rank)
+			continue;
+
+		const std::uint64_t length = messages[r].size();
+		outgoing[r].resize(sizeof(length) + length);
+		std::memcpy(outgoing[r].data(), &length, sizeof(length));
+		std::copy(messages[r].begin(), messages[r].end(), outgoing[r].begin() + sizeof(length));
+		received[r].resize(sizeof(std::uint64_t)); // L'en-tête d'abord, le message une fois sa taille connue
+		pending += 2;
+	}
+
+	std::vector<pollfd> polled;
+
+	while (pending > 0) {
+		polled.clear();
+
+		for (std::size_t r = 0; r < nb_ranks; ++r) {
+			if (r == current_rank)
+				continue;
+
+			short events = 0;
+			if (written[r] < outgoing[r].size())
+				events |= POLLOUT;
+			if (read[r] < received[r].size())
+				events |= POLLIN;
+			if (events)
+				polled.push_back({ sockets[r], events, 0 });
+		}
+
+		if (poll(polled.data(), polled.size(), -1) < 0) {
+			if (errno == EINTR) // Interrompu par un signal
+				continue;
+
+			std::cerr << "poll impossible (" << std::strerror(errno) << ")" << std::endl;
+			std::exit(EXIT_FAILURE);
+		}
+
+		for (const auto &entry : polled) {
+			const auto r = static_cast<std::size_t>(std::find(sockets.begin(), sockets.end(), entry.fd) - sockets.begin());
+
+			if (entry.revents & (POLLERR | POLLNVAL))
+				disconnected(r, entry.revents & POLLNVAL ? "socket invalide" : "erreur de socket");
+
+			if (entry.revents & POLLOUT) {
+				// MSG_NOSIGNAL : un rang arrêté donne EPIPE plutôt que SIGPIPE
+				const auto sent = send(entry.fd, outgoing[r].data() + written[r], outgoing[r].size() - written[r], MSG_NOSIGNAL);
+
+				if (sent < 0 && !is_transient(errno))
+					disconnected(r, std::strerror(errno));
+
+				if (sent > 0 && (written[r] += static_cast<std::size_t>(sent)) == outgoing[r].size())
+					--pending;
+			}
+
+			// Raccroché alors que tout est reçu : c'est l'envoi ci-dessus qui échoue (EPIPE)
+			if (entry.revents & (POLLIN | POLLHUP) && read[r] < received[r].size()) {
+				const auto count = ::read(entry.fd, received[r].data() + read[r], received[r].size() - read[r]);
+
+				if (count == 0)
+					disconnected(r, "fin de flux");
+
+				if (count < 0 && !is_transient(errno))
+					disconnected(r, std::strerror(errno));
+
+				if (count > 0 && (read[r] += static_cast<std::size_t>(count)) == received[r].size()) {
+					if (!has_header[r]) {
+						std::uint64_t length;
+						std::memcpy(&length, received[r].data(), sizeof(length));
+						received[r].assign(length, 0);
+						read[r] = 0;
+						has_header[r] = true;
+					}
+
+					if (read[r] == received[r].size())
+						--pending;
+				}
+			}
+		}
+	}
+
+	return received;
+}
+
+
+
+// Ferme toutes les extrémités ouvertes (lancement abandonné)
+
+static void close_pairs(const std::vector<std::vector<int>> &pairs) {
+	for (const auto &ends : pairs)
+		for (const int socket : ends)
+			if (socket >= 0)
+				close(socket);
+}
+
+#endif
+
+// Lance les rangs
+
+std::unique_ptr<Transport> launch_ranks(std::size_t nb_ranks) {
+#ifdef _WIN32
+	if (nb_ranks > 1)
+		std::cerr << "Décomposition en domaines indisponible sous Windows : un seul rang" << std::endl;
+
+	return std::make_unique<Local_transport>();
+#else
+	if (nb_ranks <= 1)
+		return std::make_unique<Local_transport>();
+
+	// Une paire de sockets par couple de rangs : pairs[i][j] est l'extrémité du rang i vers le rang j
+	std::vector<std::vector<int>> pairs(nb_ranks, std::vector<int>(nb_ranks, -1));
+
+	for (std::size_t i = 0; i < nb_ranks; ++i)
+		for (std::size_t j = i + 1; j < nb_ranks; ++j) {
+			int ends[2];
+			if (socketpair(AF_UNIX, SOCK_STREAM, 0, ends) != 0) {
+				std::cerr << "socketpair impossible (" << std::strerror(errno) << ") : un seul rang" << std::endl;
+				close_pairs(pairs);
+				return std::make_unique<Local_transport>();
+			}
+
+			pairs[i][j] = ends[0];
+			pairs[j][i] = ends[1];
+		}
+
+	std::cout.flush(); // Sinon le tampon est écrit par chaque processus
+	std::cerr.flush();
+
+	std::vector<int> children;
+	std::size_t rank = 0;
+
+	for (std::size_t r = 1; r < nb_ranks; ++r) {
+		const pid_t child = fork();
+
+		if (child < 0) {
+			// Rang manquant : les autres attendraient son premier message indéfiniment
+			std::cerr << "fork impossible (" << std::strerror(errno) << ") : un seul rang" << std::endl;
+
+			for (const pid_t started : children) {
+				kill(started, SIGKILL);
+				waitpid(started, nullptr, 0);
+			}
+
+			close_pairs(pairs);
+			return std::make_unique<Local_transport>();
+		}
+
+		if (child == 0) {
+			rank = r;
+			children.clear();
+			break;
+		}
+
+		children.push_back(child);
+	}
+
+	// Chaque processus ne garde que ses propres extrémités
+	for (std::size_t i = 0; i < nb_ranks; ++i)
+		if (i != rank)
+			for (const int socket : pairs[i])
+				if (socket >= 0)
+					close(socket);
+
+	return std::make_unique<Socket_transport>(rank, pairs[rank], children);
+#endif
+}
@@ -0,0 +1,45 @@
+#include "potential.h"
+#include "utils.h"
+
+// Vérifie qu'une accélération est finie et proche de celle attendue
+
+static bool check(const char *name, const glm::dvec3 &acceleration, const glm::dvec3 &expected) {
+	const bool finite = std::isfinite(acceleration.x) && std::isfinite(acceleration.y) && std::isfinite(acceleration.z);
+	const bool close = glm::length(acceleration - expected) <= 1e-12 * std::max(glm::length(expected), 1e-300);
+
+	if (!finite || !close)
+		std::cerr << name << " : (" << acceleration.x << ", " << acceleration.y << ", " << acceleration.z << "), attendu ("
+				  << expected.x << ", " << expected.y << ", " << expected.z << ")" << std::endl;
+
+	return finite && close;
+}
+
+
+
+// Disque de Miyamoto-Nagai évalué dans son plan (z = 0), y compris à la limite de Kuzmin (height nul)
+
+int main() {
+	External_potential disk;
+	disk.profile = miyamoto_nagai_disk;
+	disk.mass = 1e41;
+	disk.scale = 3. * LIGHT_YEAR;
+	bool success = true;
+
+	for (const double height : { 0., 0.3 * LIGHT_YEAR }) {
+		disk.height = height;
+
+		// Dans le plan : accélération radiale -G M R / (R^2 + (a + b)^2)^(3/2), sans composante verticale
+		const double radius = 5. * LIGHT_YEAR, azb = disk.scale + height;
+		const double d2 = radius * radius + azb * azb;
+		success &= check(height > 0. ? "plan (height > 0)" : "plan (Kuzmin)", disk.acceleration({ radius, 0., 0. }),
+						 { -G * disk.mass * radius / (d2 * std::sqrt(d2)), 0., 0. });
+
+		// Au centre : nulle
+		success &= check(height > 0. ? "centre (height > 0)" : "centre (Kuzmin)", disk.acceleration({ 0., 0., 0. }), { 0., 0., 0. });
+
+		success &= std::isfinite(disk.potential({ radius, 0., 0. }));
+	}
+
+	std::cout << (success ? "potential : ok" : "potential : échec") << std::endl;
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}